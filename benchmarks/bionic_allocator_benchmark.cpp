@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "private/bionic_allocator.h"
+#include "util.h"
+
+// The BionicAllocator backs the linker and dynamic TLS. These benchmarks have
+// state.range(0) threads each run a burst of small allocations and frees, the
+// pattern of many threads touching thread_local data in dlopen'ed libraries,
+// either serialized by one lock (how dynamic TLS used to share the allocator)
+// or through per-thread caches. Thread creation is included in the time, so
+// compare the two rather than reading the absolute numbers.
+
+static constexpr size_t kOpsPerThread = 10000;
+static constexpr size_t kLiveAllocations = 8;
+
+template <typename AllocFn, typename FreeFn>
+static void AllocFreeBurst(AllocFn alloc_fn, FreeFn free_fn) {
+  void* ptrs[kLiveAllocations] = {};
+  for (size_t i = 0; i < kOpsPerThread; ++i) {
+    void*& slot = ptrs[i % kLiveAllocations];
+    if (slot != nullptr) free_fn(slot);
+    // Cycle through the 16 to 256 byte size classes.
+    slot = alloc_fn(16 << (i % 5));
+  }
+  for (void* ptr : ptrs) free_fn(ptr);
+}
+
+template <typename ThreadFn>
+static void RunThreads(benchmark::State& state, ThreadFn thread_fn) {
+  const size_t thread_count = state.range(0);
+  while (state.KeepRunning()) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads.emplace_back(thread_fn);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * thread_count * kOpsPerThread);
+}
+
+static void BM_bionic_allocator_locked(benchmark::State& state) {
+  static BionicAllocator allocator;
+  static std::mutex lock;
+  RunThreads(state, []() {
+    AllocFreeBurst(
+        [](size_t size) {
+          std::lock_guard<std::mutex> guard(lock);
+          return allocator.alloc(size);
+        },
+        [](void* ptr) {
+          std::lock_guard<std::mutex> guard(lock);
+          allocator.free(ptr);
+        });
+  });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_bionic_allocator_locked, "NUM_THREADS");
+
+static void BM_bionic_allocator_cached(benchmark::State& state) {
+  static BionicAllocator allocator;
+  RunThreads(state, []() {
+    BionicAllocatorCache cache = {};
+    AllocFreeBurst([&cache](size_t size) { return allocator.alloc(size, &cache); },
+                   [&cache](void* ptr) { allocator.free(ptr, &cache); });
+    allocator.flush_cache(&cache);
+  });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_bionic_allocator_cached, "NUM_THREADS");
@@ -34,6 +34,10 @@
 #include <tinyxml2.h>
 #include "util.h"
 
+#if defined(__BIONIC__)
+#include "platform/bionic/ifunc.h"
+#endif
+
 #define _STR(x) #x
 #define STRINGFY(x) _STR(x)
 
@@ -93,6 +97,8 @@ static struct option g_long_options[] =
   {"bionic_xml", required_argument, nullptr, 'x'},
   {"bionic_iterations", required_argument, nullptr, 'i'},
   {"bionic_extra", required_argument, nullptr, 'a'},
+  {"bionic_ifunc_variants", no_argument, nullptr, 'v'},
+  {"bionic_size_distribution", required_argument, nullptr, 's'},
   {"help", no_argument, nullptr, 'h'},
   {nullptr, 0, nullptr, 0},
 };
@@ -105,6 +111,8 @@ void Usage() {
   printf("                  [--bionic_xml=<path_to_xml>]\n");
   printf("                  [--bionic_iterations=<num_iter>]\n");
   printf("                  [--bionic_extra=\"<fn_name> <arg1> <arg 2> ...\"]\n");
+  printf("                  [--bionic_ifunc_variants]\n");
+  printf("                  [--bionic_size_distribution=<path_to_distribution>]\n");
   printf("                  [<Google benchmark flags>]\n");
   printf("Google benchmark flags:\n");
 
@@ -155,7 +163,7 @@ bench_opts_t ParseOpts(int argc, char** argv) {
   extern int opterr;
   opterr = 0;
 
-  while ((opt = getopt_long(argc, argv, "c:x:i:a:h", g_long_options, &option_index)) != -1) {
+  while ((opt = getopt_long(argc, argv, "c:x:i:a:vs:h", g_long_options, &option_index)) != -1) {
     if (opt == -1) {
       break;
     }
@@ -200,6 +208,17 @@ bench_opts_t ParseOpts(int argc, char** argv) {
           Usage();
         }
         break;
+      case 'v':
+        opts.ifunc_variants = true;
+        break;
+      case 's':
+        if (*optarg) {
+          opts.size_distribution_path = optarg;
+        } else {
+          printf("ERROR: no argument specified for bionic_size_distribution\n");
+          Usage();
+        }
+        break;
       case 'h':
         Usage();
         break;
@@ -221,6 +240,53 @@ void LockAndRun(benchmark::State& state, benchmark_func_t func_to_bench, int cpu
   reinterpret_cast<void(*) (benchmark::State&)>(func_to_bench)(state);
 }
 
+// Runs a benchmark with GetIfuncVariant() returning `variant_fn` for `ifunc_name`.
+void LockAndRunIfuncVariant(benchmark::State& state, benchmark_func_t func_to_bench,
+                            int cpu_to_lock, std::string ifunc_name, void* variant_fn) {
+  SetIfuncVariant(ifunc_name.c_str(), variant_fn);
+  LockAndRun(state, func_to_bench, cpu_to_lock);
+  SetIfuncVariant(nullptr, nullptr);
+}
+
+struct ifunc_variant_t {
+  std::string name;
+  void* fn;
+};
+
+// Returns the ifunc that a string benchmark such as BM_string_memmove_non_overlapping measures,
+// and the variants of it this CPU can run. Returns no variants for other benchmarks.
+#if defined(__BIONIC__)
+static std::vector<ifunc_variant_t> GetIfuncVariants(const std::string& fn_name,
+                                                     std::string* ifunc_name) {
+  std::vector<ifunc_variant_t> result;
+  static constexpr char kStringPrefix[] = "BM_string_";
+  if (!android::base::StartsWith(fn_name, kStringPrefix)) return result;
+  std::string measured = fn_name.substr(sizeof(kStringPrefix) - 1);
+
+  // The benchmark name is the function name, optionally followed by "_" and a description.
+  ifunc_name->clear();
+  for (size_t i = 0; const char* function = android_ifunc_get_function(i); ++i) {
+    if (measured == function || android::base::StartsWith(measured, std::string(function) + "_")) {
+      *ifunc_name = function;
+      break;
+    }
+  }
+  if (ifunc_name->empty()) return result;
+
+  std::vector<android_ifunc_variant> variants(
+      android_ifunc_get_variants(ifunc_name->c_str(), nullptr, 0));
+  android_ifunc_get_variants(ifunc_name->c_str(), variants.data(), variants.size());
+  for (const auto& variant : variants) {
+    if (variant.supported) result.push_back({variant.name, variant.func});
+  }
+  return result;
+}
+#else
+static std::vector<ifunc_variant_t> GetIfuncVariants(const std::string&, std::string*) {
+  return {};
+}
+#endif
+
 static constexpr char kOnebufManualStr[] = "AT_ONEBUF_MANUAL_ALIGN_";
 static constexpr char kTwobufManualStr[] = "AT_TWOBUF_MANUAL_ALIGN1_";
 
@@ -366,6 +432,26 @@ void RegisterGoogleBenchmarks(bench_opts_t primary_opts, bench_opts_t secondary_
   }
 
   benchmark_func_t benchmark_function = g_str_to_func.at(fn_name).first;
+  if (primary_opts.ifunc_variants || secondary_opts.ifunc_variants) {
+    std::string ifunc_name;
+    std::vector<ifunc_variant_t> variants = GetIfuncVariants(fn_name, &ifunc_name);
+    if (!variants.empty()) {
+      for (const auto& variant : variants) {
+        std::string variant_fn_name = fn_name + "/" + variant.name;
+        for (const std::vector<int64_t>& args : (*run_args)) {
+          auto registration = benchmark::RegisterBenchmark(variant_fn_name.c_str(),
+                                                           LockAndRunIfuncVariant,
+                                                           benchmark_function, cpu_to_use,
+                                                           ifunc_name, variant.fn)->Args(args);
+          if (iterations_to_use > 0) {
+            registration->Iterations(iterations_to_use);
+          }
+        }
+      }
+      return;
+    }
+  }
+
   for (const std::vector<int64_t>& args : (*run_args)) {
     auto registration = benchmark::RegisterBenchmark(fn_name.c_str(), LockAndRun,
                                                      benchmark_function,
@@ -524,6 +610,8 @@ std::map<std::string, args_vector_t> GetShorthand() {
     // that can be created with the current property area size.
     {"NUM_PROPS", args_vector_t{ {1}, {4}, {16}, {64}, {128}, {256}, {512} }},
 
+    {"NUM_THREADS", args_vector_t{ {1}, {2}, {4}, {8}, {16}, {32} }},
+
     {"MATH_COMMON", args_vector_t{ {0}, {1}, {2}, {3} }},
     {"MATH_SINCOS_COMMON", args_vector_t{ {0}, {1}, {2}, {3}, {4}, {5}, {6}, {7} }},
   };
@@ -587,6 +675,31 @@ int main(int argc, char** argv) {
     opts.xmlpath = file;
   }
 
+  if (!opts.size_distribution_path.empty()) {
+    std::string path(opts.size_distribution_path);
+    if (!FileExists(path)) {
+      // See if this is a file in the suites directory.
+      path = android::base::GetExecutableDirectory() + "/suites/" + path;
+      if (opts.size_distribution_path[0] == '/' || !FileExists(path)) {
+        printf("Cannot find size distribution %s: does not exist or is not a file.\n",
+               opts.size_distribution_path.c_str());
+        return 1;
+      }
+    }
+    std::string text;
+    size_dist_t dist;
+    std::string error;
+    if (!android::base::ReadFileToString(path, &text)) {
+      printf("Failed to read size distribution %s.\n", path.c_str());
+      return 1;
+    }
+    if (!ParseSizeDistribution(text, &dist, &error)) {
+      printf("Bad size distribution %s: %s\n", path.c_str(), error.c_str());
+      return 1;
+    }
+    SetSizeDistribution(dist);
+  }
+
   if (!opts.xmlpath.empty()) {
     if (int err = RegisterXmlBenchmarks(opts, args_shorthand)) {
       return err;
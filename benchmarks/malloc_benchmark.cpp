@@ -34,6 +34,10 @@
 #include <benchmark/benchmark.h>
 #include "util.h"
 
+#if defined(__BIONIC__)
+#include "platform/bionic/malloc.h"
+#endif
+
 #if defined(__BIONIC__)
 
 static void RunMalloptPurge(benchmark::State& state, int purge_value) {
@@ -78,4 +82,71 @@ static void BM_mallopt_purge_all(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_mallopt_purge_all);
 
+// Allocates a batch of objects and then frees all of them, the pattern of
+// tearing down a large data structure. Only the frees are timed.
+static void RunFreeBatch(benchmark::State& state, void (*free_func)(void*, size_t)) {
+  static constexpr size_t kNumAllocs = 1024;
+  const size_t nbytes = state.range(0);
+  void* ptrs[kNumAllocs];
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (size_t i = 0; i < kNumAllocs; i++) {
+      ptrs[i] = malloc(nbytes);
+      if (ptrs[i] == nullptr) {
+        state.SkipWithError("Failed to allocate memory");
+      }
+    }
+    state.ResumeTiming();
+
+    for (size_t i = 0; i < kNumAllocs; i++) {
+      free_func(ptrs[i], nbytes);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumAllocs);
+}
+
+static void BM_malloc_free_batch(benchmark::State& state) {
+  RunFreeBatch(state, [](void* ptr, size_t) { free(ptr); });
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_batch, "AT_COMMON_SIZES");
+
+static void BM_malloc_free_sized_batch(benchmark::State& state) {
+  RunFreeBatch(state, free_sized);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_sized_batch, "AT_COMMON_SIZES");
+
+// Allocates and frees a batch of same sized objects, one call per object.
+static void BM_malloc_free_loop(benchmark::State& state) {
+  static constexpr size_t kNumAllocs = 1024;
+  const size_t nbytes = state.range(0);
+  void* ptrs[kNumAllocs];
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumAllocs; i++) {
+      ptrs[i] = malloc(nbytes);
+    }
+    benchmark::DoNotOptimize(ptrs);
+    for (size_t i = 0; i < kNumAllocs; i++) {
+      free(ptrs[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumAllocs);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_malloc_free_loop, "AT_COMMON_SIZES");
+
+// The same as above using a single call to allocate and a single call to free.
+static void BM_android_malloc_free_batch(benchmark::State& state) {
+  static constexpr size_t kNumAllocs = 1024;
+  const size_t nbytes = state.range(0);
+  void* ptrs[kNumAllocs];
+  for (auto _ : state) {
+    if (android_malloc_batch(nbytes, ptrs, kNumAllocs) != kNumAllocs) {
+      state.SkipWithError("Failed to allocate memory");
+    }
+    benchmark::DoNotOptimize(ptrs);
+    android_free_batch(ptrs, kNumAllocs);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumAllocs);
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_android_malloc_free_batch, "AT_COMMON_SIZES");
+
 #endif
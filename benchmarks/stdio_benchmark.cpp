@@ -19,6 +19,10 @@
 #include <stdio.h>
 #include <stdio_ext.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
 
 #include <android-base/file.h>
 #include <benchmark/benchmark.h>
@@ -172,6 +176,106 @@ void BM_stdio_fopen_fgetc_fclose_no_locking(benchmark::State& state) {
 }
 BIONIC_BENCHMARK_WITH_ARG(BM_stdio_fopen_fgetc_fclose_no_locking, "1024");
 
+// Reads a 64MiB file from start to end in chunks of state.range(0) bytes, which
+// are small enough to go through the FILE's buffer. The file is sparse, so this
+// measures system call and copying overhead rather than the storage.
+static void FreadSequentialLargeFile(benchmark::State& state, const char* mode) {
+  static constexpr off_t kFileSize = 64 * 1024 * 1024;
+  size_t chunk_size = state.range(0);
+  TemporaryFile tf;
+  if (ftruncate(tf.fd, kFileSize) == -1) err(1, "ftruncate failed");
+  std::vector<char> buf(chunk_size);
+
+  for (auto _ : state) {
+    FILE* fp = fopen(tf.path, mode);
+    if (fp == nullptr) err(1, "fopen failed");
+    __fsetlocking(fp, FSETLOCKING_BYCALLER);
+    while (fread(buf.data(), chunk_size, 1, fp) == 1) {
+    }
+    fclose(fp);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * kFileSize);
+}
+
+static void BM_stdio_fread_sequential_large_file(benchmark::State& state) {
+  FreadSequentialLargeFile(state, "re");
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_stdio_fread_sequential_large_file, "256");
+
+static void BM_stdio_fread_sequential_large_file_mmap(benchmark::State& state) {
+  FreadSequentialLargeFile(state, "rme");
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_stdio_fread_sequential_large_file_mmap, "256");
+
+// As above, but a line at a time.
+static void FgetsSequentialLargeFile(benchmark::State& state, const char* mode) {
+  static constexpr size_t kLines = 256 * 1024;
+  TemporaryFile tf;
+  std::string line(255, 'x');
+  line += '\n';
+  for (size_t i = 0; i < kLines; ++i) {
+    if (write(tf.fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+      err(1, "write failed");
+    }
+  }
+
+  for (auto _ : state) {
+    FILE* fp = fopen(tf.path, mode);
+    if (fp == nullptr) err(1, "fopen failed");
+    __fsetlocking(fp, FSETLOCKING_BYCALLER);
+    char buf[512];
+    while (fgets(buf, sizeof(buf), fp) != nullptr) {
+    }
+    fclose(fp);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * kLines * line.size());
+}
+
+static void BM_stdio_fgets_sequential_large_file(benchmark::State& state) {
+  FgetsSequentialLargeFile(state, "re");
+}
+BIONIC_BENCHMARK(BM_stdio_fgets_sequential_large_file);
+
+static void BM_stdio_fgets_sequential_large_file_mmap(benchmark::State& state) {
+  FgetsSequentialLargeFile(state, "rme");
+}
+BIONIC_BENCHMARK(BM_stdio_fgets_sequential_large_file_mmap);
+
+// Opens and then closes 50,000 streams at a time, like a server with that many
+// connections. fmemopen() is used so that no file descriptors are needed.
+static void BM_stdio_fmemopen_fclose_50k(benchmark::State& state) {
+  static constexpr size_t kStreams = 50000;
+  char buf[16] = {};
+  std::vector<FILE*> fps(kStreams);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kStreams; ++i) {
+      fps[i] = fmemopen(buf, sizeof(buf), "r");
+      if (fps[i] == nullptr) errx(1, "ERROR: fmemopen failed");
+    }
+    for (FILE* fp : fps) fclose(fp);
+  }
+  state.SetItemsProcessed(state.iterations() * kStreams);
+}
+BIONIC_BENCHMARK(BM_stdio_fmemopen_fclose_50k);
+
+// Opens and closes a single stream while 50,000 others are open.
+static void BM_stdio_fmemopen_fclose_with_50k_open(benchmark::State& state) {
+  static constexpr size_t kStreams = 50000;
+  char buf[16] = {};
+  std::vector<FILE*> fps(kStreams);
+  for (size_t i = 0; i < kStreams; ++i) {
+    fps[i] = fmemopen(buf, sizeof(buf), "r");
+    if (fps[i] == nullptr) errx(1, "ERROR: fmemopen failed");
+  }
+  for (auto _ : state) {
+    FILE* fp = fmemopen(buf, sizeof(buf), "r");
+    if (fp == nullptr) errx(1, "ERROR: fmemopen failed");
+    fclose(fp);
+  }
+  for (FILE* fp : fps) fclose(fp);
+}
+BIONIC_BENCHMARK(BM_stdio_fmemopen_fclose_with_50k_open);
+
 static void BM_stdio_printf_literal(benchmark::State& state) {
   while (state.KeepRunning()) {
     char buf[BUFSIZ];
@@ -197,6 +301,22 @@ static void BM_stdio_printf_d(benchmark::State& state) {
 }
 BIONIC_BENCHMARK(BM_stdio_printf_d);
 
+static void BM_stdio_printf_f(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    char buf[BUFSIZ];
+    snprintf(buf, sizeof(buf), "{\"latency_ms\": %.3f, \"ratio\": %f}", 12.3456789, 0.125);
+  }
+}
+BIONIC_BENCHMARK(BM_stdio_printf_f);
+
+static void BM_stdio_printf_g(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    char buf[BUFSIZ];
+    snprintf(buf, sizeof(buf), "{\"value\": %g, \"exact\": %.17g}", 1234.5678, 0.1);
+  }
+}
+BIONIC_BENCHMARK(BM_stdio_printf_g);
+
 static void BM_stdio_printf_1$s(benchmark::State& state) {
   while (state.KeepRunning()) {
     char buf[BUFSIZ];
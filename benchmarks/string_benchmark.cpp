@@ -18,9 +18,22 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include <benchmark/benchmark.h>
 #include <util.h>
 
+#if defined(__BIONIC__)
+// The implementation of `fn` to benchmark. This is normally `fn` itself, but see
+// --bionic_ifunc_variants.
+#define IFUNC_VARIANT(type, fn) IfuncVariant<type>(#fn, fn)
+#else
+#define IFUNC_VARIANT(type, fn) [](auto... args) { return fn(args...); }
+#endif
+
 static void BM_string_memcmp(benchmark::State& state) {
   const size_t nbytes = state.range(0);
   const size_t src_alignment = state.range(1);
@@ -31,8 +44,9 @@ static void BM_string_memcmp(benchmark::State& state) {
   char* src_aligned = GetAlignedPtrFilled(&src, src_alignment, nbytes, 'x');
   char* dst_aligned = GetAlignedPtrFilled(&dst, dst_alignment, nbytes, 'x');
 
+  auto memcmp_fn = IFUNC_VARIANT(int(const void*, const void*, size_t), memcmp);
   while (state.KeepRunning()) {
-    benchmark::DoNotOptimize(memcmp(dst_aligned, src_aligned, nbytes));
+    benchmark::DoNotOptimize(memcmp_fn(dst_aligned, src_aligned, nbytes));
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -49,8 +63,9 @@ static void BM_string_memcpy(benchmark::State& state) {
   char* src_aligned = GetAlignedPtrFilled(&src, src_alignment, nbytes, 'x');
   char* dst_aligned = GetAlignedPtr(&dst, dst_alignment, nbytes);
 
+  auto memcpy_fn = IFUNC_VARIANT(void*(void*, const void*, size_t), memcpy);
   while (state.KeepRunning()) {
-    memcpy(dst_aligned, src_aligned, nbytes);
+    memcpy_fn(dst_aligned, src_aligned, nbytes);
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -67,8 +82,9 @@ static void BM_string_memmove_non_overlapping(benchmark::State& state) {
   char* src_aligned = GetAlignedPtrFilled(&src, src_alignment, nbytes, 'x');
   char* dst_aligned = GetAlignedPtrFilled(&dst, dst_alignment, nbytes, 'y');
 
+  auto memmove_fn = IFUNC_VARIANT(void*(void*, const void*, size_t), memmove);
   while (state.KeepRunning()) {
-    memmove(dst_aligned, src_aligned, nbytes);
+    memmove_fn(dst_aligned, src_aligned, nbytes);
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -82,8 +98,9 @@ static void BM_string_memmove_overlap_dst_before_src(benchmark::State& state) {
   std::vector<char> buf(3 * alignment + nbytes + 1, 'x');
   char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes + 1, 'x');
 
+  auto memmove_fn = IFUNC_VARIANT(void*(void*, const void*, size_t), memmove);
   while (state.KeepRunning()) {
-    memmove(buf_aligned, buf_aligned + 1, nbytes);  // Worst-case overlap.
+    memmove_fn(buf_aligned, buf_aligned + 1, nbytes);  // Worst-case overlap.
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -97,8 +114,9 @@ static void BM_string_memmove_overlap_src_before_dst(benchmark::State& state) {
   std::vector<char> buf;
   char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes + 1, 'x');
 
+  auto memmove_fn = IFUNC_VARIANT(void*(void*, const void*, size_t), memmove);
   while (state.KeepRunning()) {
-    memmove(buf_aligned + 1, buf_aligned, nbytes);  // Worst-case overlap.
+    memmove_fn(buf_aligned + 1, buf_aligned, nbytes);  // Worst-case overlap.
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -112,8 +130,9 @@ static void BM_string_memset(benchmark::State& state) {
   std::vector<char> buf;
   char* buf_aligned = GetAlignedPtr(&buf, alignment, nbytes + 1);
 
+  auto memset_fn = IFUNC_VARIANT(void*(void*, int, size_t), memset);
   while (state.KeepRunning()) {
-    memset(buf_aligned, 0, nbytes);
+    memset_fn(buf_aligned, 0, nbytes);
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -128,8 +147,9 @@ static void BM_string_strlen(benchmark::State& state) {
   char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes + 1, 'x');
   buf_aligned[nbytes - 1] = '\0';
 
+  auto strlen_fn = IFUNC_VARIANT(size_t(const char*), strlen);
   while (state.KeepRunning()) {
-    benchmark::DoNotOptimize(strlen(buf_aligned));
+    benchmark::DoNotOptimize(strlen_fn(buf_aligned));
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -150,8 +170,9 @@ static void BM_string_strcat_copy_only(benchmark::State& state) {
   dst_aligned[1] = 'y';
   dst_aligned[2] = '\0';
 
+  auto strcat_fn = IFUNC_VARIANT(char*(char*, const char*), strcat);
   while (state.KeepRunning()) {
-    strcat(dst_aligned, src_aligned);
+    strcat_fn(dst_aligned, src_aligned);
     dst_aligned[2] = '\0';
   }
 
@@ -171,8 +192,9 @@ static void BM_string_strcat_seek_only(benchmark::State& state) {
   src_aligned[2] = '\0';
   dst_aligned[nbytes - 1] = '\0';
 
+  auto strcat_fn = IFUNC_VARIANT(char*(char*, const char*), strcat);
   while (state.KeepRunning()) {
-    strcat(dst_aligned, src_aligned);
+    strcat_fn(dst_aligned, src_aligned);
     dst_aligned[nbytes - 1] = '\0';
   }
 
@@ -197,8 +219,9 @@ static void BM_string_strcat_half_copy_half_seek(benchmark::State& state) {
   src_aligned[nbytes / 2 - 1] = '\0';
   dst_aligned[nbytes / 2 - 1] = '\0';
 
+  auto strcat_fn = IFUNC_VARIANT(char*(char*, const char*), strcat);
   while (state.KeepRunning()) {
-    strcat(dst_aligned, src_aligned);
+    strcat_fn(dst_aligned, src_aligned);
     dst_aligned[nbytes / 2 - 1] = '\0';
   }
 
@@ -217,8 +240,9 @@ static void BM_string_strcpy(benchmark::State& state) {
   char* dst_aligned = GetAlignedPtr(&dst, dst_alignment, nbytes);
   src_aligned[nbytes - 1] = '\0';
 
+  auto strcpy_fn = IFUNC_VARIANT(char*(char*, const char*), strcpy);
   while (state.KeepRunning()) {
-    strcpy(dst_aligned, src_aligned);
+    strcpy_fn(dst_aligned, src_aligned);
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -237,8 +261,9 @@ static void BM_string_strcmp(benchmark::State& state) {
   s1_aligned[nbytes - 1] = '\0';
   s2_aligned[nbytes - 1] = '\0';
 
+  auto strcmp_fn = IFUNC_VARIANT(int(const char*, const char*), strcmp);
   while (state.KeepRunning()) {
-    benchmark::DoNotOptimize(strcmp(s1_aligned, s2_aligned));
+    benchmark::DoNotOptimize(strcmp_fn(s1_aligned, s2_aligned));
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -255,8 +280,9 @@ static void BM_string_strncmp(benchmark::State& state) {
   char* s1_aligned = GetAlignedPtrFilled(&s1, s1_alignment, nbytes, 'x');
   char* s2_aligned = GetAlignedPtrFilled(&s2, s2_alignment, nbytes, 'x');
 
+  auto strncmp_fn = IFUNC_VARIANT(int(const char*, const char*, size_t), strncmp);
   for (auto _ : state) {
-    benchmark::DoNotOptimize(strncmp(s1_aligned, s2_aligned, nbytes));
+    benchmark::DoNotOptimize(strncmp_fn(s1_aligned, s2_aligned, nbytes));
   }
 
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
@@ -282,8 +308,9 @@ static void BM_string_strstr(benchmark::State& state) {
   haystack_aligned[nbytes - 1] = '\0';
   needle_aligned[needle.size() - 1] = '\0';
 
+  auto strstr_fn = IFUNC_VARIANT(char*(const char*, const char*), strstr);
   while (state.KeepRunning()) {
-    if (strstr(haystack_aligned, needle_aligned) == nullptr) {
+    if (strstr_fn(haystack_aligned, needle_aligned) == nullptr) {
       errx(1, "ERROR: strstr failed to find valid substring.");
     }
   }
@@ -292,6 +319,121 @@ static void BM_string_strstr(benchmark::State& state) {
 }
 BIONIC_BENCHMARK_WITH_ARG(BM_string_strstr, "AT_ALIGNED_TWOBUF");
 
+// Fills the haystack with text that rarely matches the needle's first and
+// last bytes (the common case), with the needle itself at the very end.
+static char* GetShortNeedleHaystack(std::vector<char>* haystack, size_t alignment, size_t nbytes,
+                                    const char* needle) {
+  const size_t needle_len = strlen(needle);
+  nbytes = std::max(nbytes, needle_len + 1);
+  char* haystack_aligned = GetAlignedPtr(haystack, alignment, nbytes);
+  for (size_t i = 0; i < nbytes - 1; i++) {
+    haystack_aligned[i] = "the quick brown fox jumps over a lazy dog "[i % 42];
+  }
+  memcpy(haystack_aligned + nbytes - 1 - needle_len, needle, needle_len);
+  haystack_aligned[nbytes - 1] = '\0';
+  return haystack_aligned;
+}
+
+static void BM_string_strstr_short_needle(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetShortNeedleHaystack(&haystack, haystack_alignment, nbytes, "needle");
+
+  auto strstr_fn = IFUNC_VARIANT(char*(const char*, const char*), strstr);
+  while (state.KeepRunning()) {
+    if (strstr_fn(haystack_aligned, "needle") == nullptr) {
+      errx(1, "ERROR: strstr failed to find valid substring.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strstr_short_needle, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_memmem_short_needle(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetShortNeedleHaystack(&haystack, haystack_alignment, nbytes, "needle");
+  const size_t haystack_len = strlen(haystack_aligned);
+
+  auto memmem_fn = IFUNC_VARIANT(void*(const void*, size_t, const void*, size_t), memmem);
+  while (state.KeepRunning()) {
+    if (memmem_fn(haystack_aligned, haystack_len, "needle", 6) == nullptr) {
+      errx(1, "ERROR: memmem failed to find valid substring.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_memmem_short_needle, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strcasestr_short_needle(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetShortNeedleHaystack(&haystack, haystack_alignment, nbytes, "Needle");
+
+  auto strcasestr_fn = IFUNC_VARIANT(char*(char*, const char*), strcasestr);
+  while (state.KeepRunning()) {
+    if (strcasestr_fn(haystack_aligned, "nEEDLe") == nullptr) {
+      errx(1, "ERROR: strcasestr failed to find valid substring.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strcasestr_short_needle, "AT_ALIGNED_ONEBUF");
+
+// The worst case for a naive search: a haystack of 'a's, and a needle of
+// 'a's ending in 'b' that only matches at the very end.
+static void BM_string_strstr_pathological(benchmark::State& state) {
+  const size_t nbytes = std::max(static_cast<size_t>(state.range(0)), static_cast<size_t>(2));
+  const size_t haystack_alignment = state.range(1);
+  const size_t needle_len = std::min(nbytes - 1, static_cast<size_t>(32));
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, 'a');
+  haystack_aligned[nbytes - 2] = 'b';
+  haystack_aligned[nbytes - 1] = '\0';
+  const char* needle = haystack_aligned + nbytes - 1 - needle_len;
+
+  auto strstr_fn = IFUNC_VARIANT(char*(const char*, const char*), strstr);
+  while (state.KeepRunning()) {
+    if (strstr_fn(haystack_aligned, needle) != needle) {
+      errx(1, "ERROR: strstr failed to find valid substring.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strstr_pathological, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_memmem_pathological(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+  const size_t needle_len = std::min(nbytes, static_cast<size_t>(32));
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, 'a');
+  haystack_aligned[nbytes - 1] = 'b';
+  const char* needle = haystack_aligned + nbytes - needle_len;
+
+  auto memmem_fn = IFUNC_VARIANT(void*(const void*, size_t, const void*, size_t), memmem);
+  while (state.KeepRunning()) {
+    if (memmem_fn(haystack_aligned, nbytes, needle, needle_len) != needle) {
+      errx(1, "ERROR: memmem failed to find valid substring.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_memmem_pathological, "AT_ALIGNED_ONEBUF");
+
 static void BM_string_strchr(benchmark::State& state) {
   const size_t nbytes = state.range(0);
   const size_t haystack_alignment = state.range(1);
@@ -300,8 +442,9 @@ static void BM_string_strchr(benchmark::State& state) {
   char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, 'x');
   haystack_aligned[nbytes-1] = '\0';
 
+  auto strchr_fn = IFUNC_VARIANT(char*(const char*, int), strchr);
   while (state.KeepRunning()) {
-    if (strchr(haystack_aligned, 'y') != nullptr) {
+    if (strchr_fn(haystack_aligned, 'y') != nullptr) {
       errx(1, "ERROR: strchr found a chr where it should have failed.");
     }
   }
@@ -309,3 +452,269 @@ static void BM_string_strchr(benchmark::State& state) {
   state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
 }
 BIONIC_BENCHMARK_WITH_ARG(BM_string_strchr, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strrchr(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, 'x');
+  haystack_aligned[nbytes-1] = '\0';
+
+  auto strrchr_fn = IFUNC_VARIANT(char*(const char*, int), strrchr);
+  while (state.KeepRunning()) {
+    if (strrchr_fn(haystack_aligned, 'y') != nullptr) {
+      errx(1, "ERROR: strrchr found a chr where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strrchr, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_memchr(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t haystack_alignment = state.range(1);
+
+  std::vector<char> haystack;
+  char* haystack_aligned = GetAlignedPtrFilled(&haystack, haystack_alignment, nbytes, 'x');
+
+  auto memchr_fn = IFUNC_VARIANT(void*(const void*, int, size_t), memchr);
+  while (state.KeepRunning()) {
+    if (memchr_fn(haystack_aligned, 'y', nbytes) != nullptr) {
+      errx(1, "ERROR: memchr found a chr where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_memchr, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strnlen(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<char> buf;
+  char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes + 1, 'x');
+  buf_aligned[nbytes - 1] = '\0';
+
+  auto strnlen_fn = IFUNC_VARIANT(size_t(const char*, size_t), strnlen);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strnlen_fn(buf_aligned, nbytes + 1));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strnlen, "AT_ALIGNED_ONEBUF");
+
+// The sets a typical tokenizer uses: identifier characters and separators.
+static constexpr const char* kIdentifierChars =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+static constexpr const char* kSeparatorChars = " \t\r\n=:;,#";
+
+static void BM_string_strspn(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<char> buf;
+  char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes, 'x');
+  buf_aligned[nbytes - 1] = '\0';
+
+  auto strspn_fn = IFUNC_VARIANT(size_t(const char*, const char*), strspn);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strspn_fn(buf_aligned, kIdentifierChars));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strspn, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strcspn(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<char> buf;
+  char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes, 'x');
+  buf_aligned[nbytes - 1] = '\0';
+
+  auto strcspn_fn = IFUNC_VARIANT(size_t(const char*, const char*), strcspn);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strcspn_fn(buf_aligned, kSeparatorChars));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strcspn, "AT_ALIGNED_ONEBUF");
+
+static void BM_string_strpbrk(benchmark::State& state) {
+  const size_t nbytes = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<char> buf;
+  char* buf_aligned = GetAlignedPtrFilled(&buf, alignment, nbytes, 'x');
+  buf_aligned[nbytes - 1] = '\0';
+
+  auto strpbrk_fn = IFUNC_VARIANT(char*(const char*, const char*), strpbrk);
+  while (state.KeepRunning()) {
+    if (strpbrk_fn(buf_aligned, kSeparatorChars) != nullptr) {
+      errx(1, "ERROR: strpbrk found a separator where there wasn't one.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nbytes));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_string_strpbrk, "AT_ALIGNED_ONEBUF");
+
+// The distribution benchmarks replay a mix of call sizes and alignments, drawn either from the
+// file given with --bionic_size_distribution or from a built-in synthetic mix skewed toward small
+// sizes, as real call traces of these functions are. Each iteration is one call.
+static const size_dist_t kDefaultMemDistribution = {
+  {1, 40, 0, 0},    {2, 40, 1, 3},     {4, 120, 0, 4},   {5, 30, 3, 1},    {8, 200, 0, 0},
+  {12, 60, 4, 8},   {16, 180, 0, 0},   {24, 90, 8, 0},   {31, 40, 1, 17},  {32, 120, 0, 0},
+  {48, 60, 16, 16}, {64, 80, 0, 0},    {100, 30, 5, 9},  {128, 40, 0, 0},  {256, 20, 0, 32},
+  {512, 10, 0, 0},  {1024, 8, 32, 0},  {4096, 4, 0, 0},  {16384, 2, 0, 0}, {65536, 1, 0, 0},
+};
+
+static const size_dist_t kDefaultStringDistribution = {
+  {0, 20, 0, 0},    {1, 30, 3, 0},    {3, 60, 1, 5},    {5, 80, 0, 0},    {7, 90, 2, 2},
+  {9, 70, 0, 8},    {12, 60, 7, 0},   {15, 50, 0, 0},   {20, 40, 4, 12},  {31, 30, 0, 0},
+  {40, 20, 9, 1},   {64, 10, 0, 0},   {100, 6, 13, 0},  {256, 3, 0, 0},   {1024, 1, 0, 0},
+};
+
+static constexpr size_t kDistributionSamples = 4096;
+
+static size_dist_t SampleCalls(const size_dist_t& builtin) {
+  const size_dist_t* dist = GetSizeDistribution();
+  return SampleSizeDistribution((dist != nullptr) ? *dist : builtin, kDistributionSamples);
+}
+
+static size_t MaxSize(const size_dist_t& calls) {
+  size_t max = 0;
+  for (const auto& call : calls) max = std::max(max, call.size);
+  return max;
+}
+
+// Returns a NUL-terminated string of `size` 'x's starting `offset` bytes past a 64-byte boundary.
+// Calls with the same size and offset share a string.
+static char* GetString(std::map<std::pair<size_t, size_t>, std::vector<char>>* strings,
+                       size_t size, size_t offset) {
+  auto [it, inserted] = strings->emplace(std::make_pair(size, offset), std::vector<char>());
+  if (inserted) {
+    char* s = GetAlignedPtrFilled(&it->second, 64, size + offset + 1, 'x') + offset;
+    s[size] = '\0';
+  }
+  return GetAlignedMemory(it->second.data(), 64, 0) + offset;
+}
+
+static void BM_string_memcpy_distribution(benchmark::State& state) {
+  size_dist_t calls = SampleCalls(kDefaultMemDistribution);
+  const size_t nbytes = MaxSize(calls) + 64;
+
+  std::vector<char> src;
+  std::vector<char> dst;
+  char* src_aligned = GetAlignedPtrFilled(&src, 64, nbytes, 'x');
+  char* dst_aligned = GetAlignedPtr(&dst, 64, nbytes);
+
+  auto memcpy_fn = IFUNC_VARIANT(void*(void*, const void*, size_t), memcpy);
+  uint64_t bytes = 0;
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    const auto& call = calls[i];
+    memcpy_fn(dst_aligned + call.dst_offset, src_aligned + call.src_offset, call.size);
+    bytes += call.size;
+    i = (i + 1) % kDistributionSamples;
+  }
+
+  state.SetBytesProcessed(bytes);
+}
+BIONIC_BENCHMARK(BM_string_memcpy_distribution);
+
+static void BM_string_memset_distribution(benchmark::State& state) {
+  size_dist_t calls = SampleCalls(kDefaultMemDistribution);
+  const size_t nbytes = MaxSize(calls) + 64;
+
+  std::vector<char> buf;
+  char* buf_aligned = GetAlignedPtr(&buf, 64, nbytes);
+
+  auto memset_fn = IFUNC_VARIANT(void*(void*, int, size_t), memset);
+  uint64_t bytes = 0;
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    const auto& call = calls[i];
+    memset_fn(buf_aligned + call.src_offset, 0, call.size);
+    bytes += call.size;
+    i = (i + 1) % kDistributionSamples;
+  }
+
+  state.SetBytesProcessed(bytes);
+}
+BIONIC_BENCHMARK(BM_string_memset_distribution);
+
+static void BM_string_memcmp_distribution(benchmark::State& state) {
+  size_dist_t calls = SampleCalls(kDefaultMemDistribution);
+  const size_t nbytes = MaxSize(calls) + 64;
+
+  std::vector<char> src;
+  std::vector<char> dst;
+  char* src_aligned = GetAlignedPtrFilled(&src, 64, nbytes, 'x');
+  char* dst_aligned = GetAlignedPtrFilled(&dst, 64, nbytes, 'x');
+
+  auto memcmp_fn = IFUNC_VARIANT(int(const void*, const void*, size_t), memcmp);
+  uint64_t bytes = 0;
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    const auto& call = calls[i];
+    benchmark::DoNotOptimize(
+        memcmp_fn(dst_aligned + call.dst_offset, src_aligned + call.src_offset, call.size));
+    bytes += call.size;
+    i = (i + 1) % kDistributionSamples;
+  }
+
+  state.SetBytesProcessed(bytes);
+}
+BIONIC_BENCHMARK(BM_string_memcmp_distribution);
+
+static void BM_string_strlen_distribution(benchmark::State& state) {
+  size_dist_t calls = SampleCalls(kDefaultStringDistribution);
+
+  std::map<std::pair<size_t, size_t>, std::vector<char>> strings;
+  std::vector<const char*> srcs;
+  for (const auto& call : calls) srcs.push_back(GetString(&strings, call.size, call.src_offset));
+
+  auto strlen_fn = IFUNC_VARIANT(size_t(const char*), strlen);
+  uint64_t bytes = 0;
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strlen_fn(srcs[i]));
+    bytes += calls[i].size;
+    i = (i + 1) % kDistributionSamples;
+  }
+
+  state.SetBytesProcessed(bytes);
+}
+BIONIC_BENCHMARK(BM_string_strlen_distribution);
+
+static void BM_string_strcmp_distribution(benchmark::State& state) {
+  size_dist_t calls = SampleCalls(kDefaultStringDistribution);
+
+  // The two sides need distinct buffers even when the offsets match, so use two sets.
+  std::map<std::pair<size_t, size_t>, std::vector<char>> src_strings;
+  std::map<std::pair<size_t, size_t>, std::vector<char>> dst_strings;
+  std::vector<std::pair<const char*, const char*>> args;
+  for (const auto& call : calls) {
+    args.emplace_back(GetString(&src_strings, call.size, call.src_offset),
+                      GetString(&dst_strings, call.size, call.dst_offset));
+  }
+
+  auto strcmp_fn = IFUNC_VARIANT(int(const char*, const char*), strcmp);
+  uint64_t bytes = 0;
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(strcmp_fn(args[i].second, args[i].first));
+    bytes += calls[i].size;
+    i = (i + 1) % kDistributionSamples;
+  }
+
+  state.SetBytesProcessed(bytes);
+}
+BIONIC_BENCHMARK(BM_string_strcmp_distribution);
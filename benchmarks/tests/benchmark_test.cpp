@@ -37,3 +37,62 @@ TEST(benchmark, ptr_align) {
     ASSERT_EQ(aligned_ptr & (alignment - 1), 0u);
   }
 }
+
+TEST(benchmark, parse_size_distribution) {
+  size_dist_t dist;
+  std::string error;
+  ASSERT_TRUE(ParseSizeDistribution("# size count src dst\n"
+                                    "8\n"
+                                    "\n"
+                                    "16 3  # histogram\n"
+                                    "32 2 1\n"
+                                    "64 0\n"
+                                    "100 5 7 63\n",
+                                    &dist, &error))
+      << error;
+  ASSERT_EQ(4u, dist.size());
+  ASSERT_EQ(8u, dist[0].size);
+  ASSERT_EQ(1u, dist[0].count);
+  ASSERT_EQ(0u, dist[0].src_offset);
+  ASSERT_EQ(16u, dist[1].size);
+  ASSERT_EQ(3u, dist[1].count);
+  ASSERT_EQ(1u, dist[2].src_offset);
+  ASSERT_EQ(0u, dist[2].dst_offset);
+  ASSERT_EQ(100u, dist[3].size);
+  ASSERT_EQ(7u, dist[3].src_offset);
+  ASSERT_EQ(63u, dist[3].dst_offset);
+
+  ASSERT_FALSE(ParseSizeDistribution("# nothing\n", &dist, &error));
+  ASSERT_FALSE(ParseSizeDistribution("8 x\n", &dist, &error));
+  ASSERT_FALSE(ParseSizeDistribution("-8\n", &dist, &error));
+  ASSERT_FALSE(ParseSizeDistribution("8 1 64\n", &dist, &error));
+  ASSERT_FALSE(ParseSizeDistribution("8 1 4294967297\n", &dist, &error));
+#if !defined(__LP64__)
+  ASSERT_FALSE(ParseSizeDistribution("4294967296\n", &dist, &error));
+  ASSERT_EQ("line 1: bad number \"4294967296\"", error);
+#endif
+  ASSERT_FALSE(ParseSizeDistribution("8 1 0 0 0\n", &dist, &error));
+}
+
+TEST(benchmark, sample_size_distribution) {
+  size_dist_t dist = {{8, 3, 0, 0}, {4096, 1, 5, 6}};
+  size_dist_t samples = SampleSizeDistribution(dist, 4000);
+  ASSERT_EQ(4000u, samples.size());
+  size_t small = 0;
+  for (const auto& sample : samples) {
+    ASSERT_EQ(1u, sample.count);
+    if (sample.size == 8) {
+      ++small;
+    } else {
+      ASSERT_EQ(4096u, sample.size);
+      ASSERT_EQ(5u, sample.src_offset);
+      ASSERT_EQ(6u, sample.dst_offset);
+    }
+  }
+  ASSERT_GT(small, 2700u);
+  ASSERT_LT(small, 3300u);
+
+  // The sequence is the same every time.
+  size_dist_t again = SampleSizeDistribution(dist, 4000);
+  for (size_t i = 0; i < samples.size(); ++i) ASSERT_EQ(samples[i].size, again[i].size);
+}
@@ -159,6 +159,8 @@ TEST_F(SystemTests, help) {
     "                  [--bionic_xml=<path_to_xml>]\n"
     "                  [--bionic_iterations=<num_iter>]\n"
     "                  [--bionic_extra=\"<fn_name> <arg1> <arg 2> ...\"]\n"
+    "                  [--bionic_ifunc_variants]\n"
+    "                  [--bionic_size_distribution=<path_to_distribution>]\n"
     "                  [<Google benchmark flags>]\n"
     "Google benchmark flags:\n"
     "benchmark [--benchmark_list_tests={true|false}]\n"
@@ -17,13 +17,17 @@
 #include "util.h"
 
 #include <err.h>
+#include <errno.h>
 #include <math.h>
 #include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <wchar.h>
 
 #include <cstdlib>
+#include <random>
+#include <sstream>
 
 // This function returns a pointer less than 2 * alignment + or_mask bytes into the array.
 char* GetAlignedMemory(char* orig_ptr, size_t alignment, size_t or_mask) {
@@ -62,6 +66,92 @@ char* GetAlignedPtrFilled(std::vector<char>* buf, size_t alignment, size_t nbyte
   return buf_aligned;
 }
 
+static std::string g_ifunc_variant_name;
+static void* g_ifunc_variant_fn;
+
+void* GetIfuncVariant(const char* name, void* fn) {
+  return (g_ifunc_variant_fn != nullptr && g_ifunc_variant_name == name) ? g_ifunc_variant_fn : fn;
+}
+
+void SetIfuncVariant(const char* name, void* fn) {
+  g_ifunc_variant_name = (name != nullptr) ? name : "";
+  g_ifunc_variant_fn = (name != nullptr) ? fn : nullptr;
+}
+
+bool ParseSizeDistribution(const std::string& text, size_dist_t* dist, std::string* error) {
+  dist->clear();
+  std::istringstream lines(text);
+  std::string line;
+  for (size_t line_number = 1; std::getline(lines, line); ++line_number) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    std::vector<uint64_t> values;
+    std::string field;
+    std::string size_field;
+    while (fields >> field) {
+      if (values.empty()) size_field = field;
+      char* end;
+      errno = 0;
+      uint64_t value = strtoull(field.c_str(), &end, 10);
+      if (*end != '\0' || errno != 0 || field[0] == '-') {
+        *error = "line " + std::to_string(line_number) + ": bad number \"" + field + "\"";
+        return false;
+      }
+      values.push_back(value);
+    }
+    if (values.empty()) continue;
+    if (values.size() > 4) {
+      *error = "line " + std::to_string(line_number) + ": too many fields";
+      return false;
+    }
+    if (values[0] > SIZE_MAX) {
+      *error = "line " + std::to_string(line_number) + ": bad number \"" + size_field + "\"";
+      return false;
+    }
+    uint64_t src_offset = (values.size() > 2) ? values[2] : 0;
+    uint64_t dst_offset = (values.size() > 3) ? values[3] : 0;
+    if (src_offset >= 64 || dst_offset >= 64) {
+      *error = "line " + std::to_string(line_number) + ": offsets must be less than 64";
+      return false;
+    }
+    size_dist_entry_t entry;
+    entry.size = static_cast<size_t>(values[0]);
+    entry.count = (values.size() > 1) ? values[1] : 1;
+    entry.src_offset = static_cast<size_t>(src_offset);
+    entry.dst_offset = static_cast<size_t>(dst_offset);
+    if (entry.count != 0) dist->push_back(entry);
+  }
+  if (dist->empty()) {
+    *error = "no entries";
+    return false;
+  }
+  return true;
+}
+
+size_dist_t SampleSizeDistribution(const size_dist_t& dist, size_t n) {
+  std::vector<uint64_t> weights;
+  for (const auto& entry : dist) weights.push_back(entry.count);
+  std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+  std::mt19937_64 rng(0x5eed);
+
+  size_dist_t samples;
+  for (size_t i = 0; i < n; ++i) {
+    samples.push_back(dist[pick(rng)]);
+    samples.back().count = 1;
+  }
+  return samples;
+}
+
+static size_dist_t g_size_distribution;
+
+const size_dist_t* GetSizeDistribution() {
+  return g_size_distribution.empty() ? nullptr : &g_size_distribution;
+}
+
+void SetSizeDistribution(const size_dist_t& dist) {
+  g_size_distribution = dist;
+}
+
 #if defined(__APPLE__)
 
 // Darwin doesn't support this, so do nothing.
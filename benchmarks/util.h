@@ -56,6 +56,8 @@ constexpr auto KB = 1024;
 typedef struct {
   int cpu_to_lock = -1;
   long num_iterations = 0;
+  bool ifunc_variants = false;
+  std::string size_distribution_path;
   std::string xmlpath;
   std::vector<std::string> extra_benchmarks;
 } bench_opts_t;
@@ -71,6 +73,43 @@ char* GetAlignedPtrFilled(std::vector<char>* buf, size_t alignment, size_t nbyte
 
 bool LockToCPU(int cpu_to_lock);
 
+// While --bionic_ifunc_variants runs a benchmark against one variant of the ifunc `name`, returns
+// that variant. Otherwise returns `fn`.
+void* GetIfuncVariant(const char* name, void* fn);
+
+// Makes GetIfuncVariant() return `fn` for `name`, or nothing if `name` is null.
+void SetIfuncVariant(const char* name, void* fn);
+
+template <typename F>
+F* IfuncVariant(const char* name, F* fn) {
+  return reinterpret_cast<F*>(GetIfuncVariant(name, reinterpret_cast<void*>(fn)));
+}
+
+// `count` calls with a `size`-byte buffer (or string length) starting `src_offset` bytes past a
+// 64-byte boundary, and, for two-buffer functions, a destination starting `dst_offset` bytes past
+// one.
+typedef struct {
+  size_t size;
+  uint64_t count;
+  size_t src_offset;
+  size_t dst_offset;
+} size_dist_entry_t;
+
+typedef std::vector<size_dist_entry_t> size_dist_t;
+
+// Parses a size distribution: one "<size> [<count> [<src_offset> [<dst_offset>]]]" entry per line,
+// where count defaults to 1 and the offsets (0-63) to 0. '#' starts a comment. A raw trace with
+// one line per call is a valid distribution, as is a histogram.
+bool ParseSizeDistribution(const std::string& text, size_dist_t* dist, std::string* error);
+
+// Draws `n` calls from `dist`, weighted by count. The seed is fixed, so every run (and every ifunc
+// variant) replays the same sequence.
+size_dist_t SampleSizeDistribution(const size_dist_t& dist, size_t n);
+
+// The distribution given with --bionic_size_distribution, or null.
+const size_dist_t* GetSizeDistribution();
+void SetSizeDistribution(const size_dist_t& dist);
+
 static __inline __attribute__ ((__always_inline__)) void MakeAllocationResident(
     void* ptr, size_t nbytes, int pagesize) {
   uint8_t* data = reinterpret_cast<uint8_t*>(ptr);
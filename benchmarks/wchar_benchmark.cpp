@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <err.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "util.h"
+
+// The size argument is a count of wchar_t, and alignments below
+// sizeof(wchar_t) are rounded up since a misaligned wchar_t* isn't valid.
+static wchar_t* GetAlignedWideString(std::vector<wchar_t>* buf, size_t alignment, size_t nchars,
+                                     wchar_t fill) {
+  if (alignment != 0) alignment = std::max(alignment, sizeof(wchar_t));
+  wchar_t* s = GetAlignedPtr(buf, alignment, nchars + 1);
+  wmemset(s, fill, nchars);
+  s[nchars] = L'\0';
+  return s;
+}
+
+static void BM_wchar_wcslen(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<wchar_t> buf;
+  wchar_t* s = GetAlignedWideString(&buf, alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(wcslen(s));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wcslen, "AT_ALIGNED_ONEBUF");
+
+static void BM_wchar_wcsnlen(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<wchar_t> buf;
+  wchar_t* s = GetAlignedWideString(&buf, alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(wcsnlen(s, nchars + 1));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wcsnlen, "AT_ALIGNED_ONEBUF");
+
+static void BM_wchar_wcschr(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<wchar_t> buf;
+  wchar_t* s = GetAlignedWideString(&buf, alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    if (wcschr(s, L'y') != nullptr) {
+      errx(1, "ERROR: wcschr found a chr where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wcschr, "AT_ALIGNED_ONEBUF");
+
+static void BM_wchar_wcsrchr(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<wchar_t> buf;
+  wchar_t* s = GetAlignedWideString(&buf, alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    if (wcsrchr(s, L'y') != nullptr) {
+      errx(1, "ERROR: wcsrchr found a chr where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wcsrchr, "AT_ALIGNED_ONEBUF");
+
+static void BM_wchar_wmemchr(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t alignment = state.range(1);
+
+  std::vector<wchar_t> buf;
+  wchar_t* s = GetAlignedWideString(&buf, alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    if (wmemchr(s, L'y', nchars) != nullptr) {
+      errx(1, "ERROR: wmemchr found a chr where it should have failed.");
+    }
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wmemchr, "AT_ALIGNED_ONEBUF");
+
+static void BM_wchar_wcscmp(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t s1_alignment = state.range(1);
+  const size_t s2_alignment = state.range(2);
+
+  std::vector<wchar_t> buf1;
+  std::vector<wchar_t> buf2;
+  wchar_t* s1 = GetAlignedWideString(&buf1, s1_alignment, nchars, L'x');
+  wchar_t* s2 = GetAlignedWideString(&buf2, s2_alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(wcscmp(s1, s2));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wcscmp, "AT_ALIGNED_TWOBUF");
+
+static void BM_wchar_wcsncmp(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t s1_alignment = state.range(1);
+  const size_t s2_alignment = state.range(2);
+
+  std::vector<wchar_t> buf1;
+  std::vector<wchar_t> buf2;
+  wchar_t* s1 = GetAlignedWideString(&buf1, s1_alignment, nchars, L'x');
+  wchar_t* s2 = GetAlignedWideString(&buf2, s2_alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(wcsncmp(s1, s2, nchars));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wcsncmp, "AT_ALIGNED_TWOBUF");
+
+static void BM_wchar_wmemcmp(benchmark::State& state) {
+  const size_t nchars = state.range(0);
+  const size_t s1_alignment = state.range(1);
+  const size_t s2_alignment = state.range(2);
+
+  std::vector<wchar_t> buf1;
+  std::vector<wchar_t> buf2;
+  wchar_t* s1 = GetAlignedWideString(&buf1, s1_alignment, nchars, L'x');
+  wchar_t* s2 = GetAlignedWideString(&buf2, s2_alignment, nchars, L'x');
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(wmemcmp(s1, s2, nchars));
+  }
+
+  state.SetBytesProcessed(uint64_t(state.iterations()) * uint64_t(nchars) * sizeof(wchar_t));
+}
+BIONIC_BENCHMARK_WITH_ARG(BM_wchar_wmemcmp, "AT_ALIGNED_TWOBUF");
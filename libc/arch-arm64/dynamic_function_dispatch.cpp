@@ -32,103 +32,188 @@
 
 extern "C" {
 
+// The MTE variants work on any CPU, but the plain ones are faster when MTE is off. (They can read
+// past the end of a buffer, which MTE doesn't allow.)
+
 typedef void* memchr_func(const void*, int, size_t);
-DEFINE_IFUNC_FOR(memchr) {
-    if (arg->_hwcap2 & HWCAP2_MTE) {
-        RETURN_FUNC(memchr_func, __memchr_aarch64_mte);
-    } else {
-        RETURN_FUNC(memchr_func, __memchr_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(memchr) {
+    IFUNC_VARIANT(memchr_func, "aarch64", __memchr_aarch64, !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(memchr_func, "mte", __memchr_aarch64_mte, true);
 }
 
 typedef void* memcmp_func(void*, const void*, size_t);
-DEFINE_IFUNC_FOR(memcmp) {
+DEFINE_IFUNC_VARIANTS(memcmp) {
     // TODO: enable the SVE version.
-    RETURN_FUNC(memcmp_func, __memcmp_aarch64);
+    IFUNC_VARIANT(memcmp_func, "aarch64", __memcmp_aarch64, true);
 }
 
 typedef void* memcpy_func(void*, const void*, size_t);
-DEFINE_IFUNC_FOR(memcpy) {
-    if (arg->_hwcap & HWCAP_ASIMD) {
-        RETURN_FUNC(memcpy_func, __memcpy_aarch64_simd);
-    } else {
-        RETURN_FUNC(memcpy_func, __memcpy_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(memcpy) {
+    IFUNC_VARIANT(memcpy_func, "simd", __memcpy_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(memcpy_func, "aarch64", __memcpy_aarch64, true);
+}
+
+typedef void* memmem_func(const void* __haystack, size_t __haystack_size, const void* __needle, size_t __needle_size);
+DEFINE_IFUNC_VARIANTS(memmem) {
+    IFUNC_VARIANT(memmem_func, "simd", __memmem_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(memmem_func, "openbsd", memmem_openbsd, true);
 }
 
 typedef void* memmove_func(void*, const void*, size_t);
-DEFINE_IFUNC_FOR(memmove) {
-    if (arg->_hwcap & HWCAP_ASIMD) {
-        RETURN_FUNC(memmove_func, __memmove_aarch64_simd);
-    } else {
-        RETURN_FUNC(memmove_func, __memmove_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(memmove) {
+    IFUNC_VARIANT(memmove_func, "simd", __memmove_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(memmove_func, "aarch64", __memmove_aarch64, true);
 }
 
 typedef int stpcpy_func(char*, const char*);
-DEFINE_IFUNC_FOR(stpcpy) {
+DEFINE_IFUNC_VARIANTS(stpcpy) {
     // TODO: enable the SVE version.
-    RETURN_FUNC(stpcpy_func, __stpcpy_aarch64);
+    IFUNC_VARIANT(stpcpy_func, "aarch64", __stpcpy_aarch64, true);
+}
+
+typedef char* strcasestr_func(const char* __haystack, const char* __needle);
+DEFINE_IFUNC_VARIANTS(strcasestr) {
+    IFUNC_VARIANT(strcasestr_func, "simd", __strcasestr_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(strcasestr_func, "openbsd", strcasestr_openbsd, true);
 }
 
 typedef char* strchr_func(const char*, int);
-DEFINE_IFUNC_FOR(strchr) {
-    if (arg->_hwcap2 & HWCAP2_MTE) {
-        RETURN_FUNC(strchr_func, __strchr_aarch64_mte);
-    } else {
-        RETURN_FUNC(strchr_func, __strchr_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(strchr) {
+    IFUNC_VARIANT(strchr_func, "aarch64", __strchr_aarch64, !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(strchr_func, "mte", __strchr_aarch64_mte, true);
 }
 
 typedef char* strchrnul_func(const char*, int);
-DEFINE_IFUNC_FOR(strchrnul) {
-    if (arg->_hwcap2 & HWCAP2_MTE) {
-        RETURN_FUNC(strchrnul_func, __strchrnul_aarch64_mte);
-    } else {
-        RETURN_FUNC(strchrnul_func, __strchrnul_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(strchrnul) {
+    IFUNC_VARIANT(strchrnul_func, "aarch64", __strchrnul_aarch64, !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(strchrnul_func, "mte", __strchrnul_aarch64_mte, true);
 }
 
 typedef int strcmp_func(const char*, const char*);
-DEFINE_IFUNC_FOR(strcmp) {
+DEFINE_IFUNC_VARIANTS(strcmp) {
     // TODO: enable the SVE version.
-    RETURN_FUNC(strcmp_func, __strcmp_aarch64);
+    IFUNC_VARIANT(strcmp_func, "aarch64", __strcmp_aarch64, true);
 }
 
 typedef int strcpy_func(char*, const char*);
-DEFINE_IFUNC_FOR(strcpy) {
+DEFINE_IFUNC_VARIANTS(strcpy) {
     // TODO: enable the SVE version.
-    RETURN_FUNC(strcpy_func, __strcpy_aarch64);
+    IFUNC_VARIANT(strcpy_func, "aarch64", __strcpy_aarch64, true);
+}
+
+typedef size_t strcspn_func(const char* __s, const char* __reject);
+DEFINE_IFUNC_VARIANTS(strcspn) {
+    IFUNC_VARIANT(strcspn_func, "simd", __strcspn_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(strcspn_func, "openbsd", strcspn_openbsd, true);
 }
 
 typedef size_t strlen_func(const char*);
-DEFINE_IFUNC_FOR(strlen) {
-    if (arg->_hwcap2 & HWCAP2_MTE) {
-        RETURN_FUNC(strlen_func, __strlen_aarch64_mte);
-    } else {
-        RETURN_FUNC(strlen_func, __strlen_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(strlen) {
+    IFUNC_VARIANT(strlen_func, "aarch64", __strlen_aarch64, !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(strlen_func, "mte", __strlen_aarch64_mte, true);
 }
 
 typedef int strncmp_func(const char*, const char*, int);
-DEFINE_IFUNC_FOR(strncmp) {
+DEFINE_IFUNC_VARIANTS(strncmp) {
     // TODO: enable the SVE version.
-    RETURN_FUNC(strncmp_func, __strncmp_aarch64);
+    IFUNC_VARIANT(strncmp_func, "aarch64", __strncmp_aarch64, true);
 }
 
 typedef size_t strnlen_func(const char*);
-DEFINE_IFUNC_FOR(strnlen) {
+DEFINE_IFUNC_VARIANTS(strnlen) {
     // TODO: enable the SVE version.
-    RETURN_FUNC(strnlen_func, __strnlen_aarch64);
+    IFUNC_VARIANT(strnlen_func, "aarch64", __strnlen_aarch64, true);
+}
+
+typedef char* strpbrk_func(const char* __s, const char* __accept);
+DEFINE_IFUNC_VARIANTS(strpbrk) {
+    IFUNC_VARIANT(strpbrk_func, "simd", __strpbrk_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(strpbrk_func, "openbsd", strpbrk_openbsd, true);
 }
 
 typedef char* strrchr_func(const char*, int);
-DEFINE_IFUNC_FOR(strrchr) {
-    if (arg->_hwcap2 & HWCAP2_MTE) {
-        RETURN_FUNC(strrchr_func, __strrchr_aarch64_mte);
-    } else {
-        RETURN_FUNC(strrchr_func, __strrchr_aarch64);
-    }
+DEFINE_IFUNC_VARIANTS(strrchr) {
+    IFUNC_VARIANT(strrchr_func, "aarch64", __strrchr_aarch64, !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(strrchr_func, "mte", __strrchr_aarch64_mte, true);
+}
+
+typedef size_t strspn_func(const char* __s, const char* __accept);
+DEFINE_IFUNC_VARIANTS(strspn) {
+    IFUNC_VARIANT(strspn_func, "simd", __strspn_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(strspn_func, "openbsd", strspn_openbsd, true);
+}
+
+typedef char* strstr_func(const char* __haystack, const char* __needle);
+DEFINE_IFUNC_VARIANTS(strstr) {
+    IFUNC_VARIANT(strstr_func, "simd", __strstr_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(strstr_func, "openbsd", strstr_openbsd, true);
 }
 
+typedef wchar_t* wcschr_func(const wchar_t* __s, wchar_t __wc);
+DEFINE_IFUNC_VARIANTS(wcschr) {
+    IFUNC_VARIANT(wcschr_func, "simd", __wcschr_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(wcschr_func, "freebsd", wcschr_freebsd, true);
+}
+
+typedef int wcscmp_func(const wchar_t* __lhs, const wchar_t* __rhs);
+DEFINE_IFUNC_VARIANTS(wcscmp) {
+    // The SIMD version can read past the end of the strings, which MTE doesn't allow.
+    IFUNC_VARIANT(wcscmp_func, "simd", __wcscmp_aarch64_simd, (arg->_hwcap & HWCAP_ASIMD) && !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(wcscmp_func, "freebsd", wcscmp_freebsd, true);
+}
+
+typedef size_t wcslen_func(const wchar_t* __s);
+DEFINE_IFUNC_VARIANTS(wcslen) {
+    IFUNC_VARIANT(wcslen_func, "simd", __wcslen_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(wcslen_func, "freebsd", wcslen_freebsd, true);
+}
+
+typedef int wcsncmp_func(const wchar_t* __lhs, const wchar_t* __rhs, size_t __n);
+DEFINE_IFUNC_VARIANTS(wcsncmp) {
+    // The SIMD version can read past the end of the strings, which MTE doesn't allow.
+    IFUNC_VARIANT(wcsncmp_func, "simd", __wcsncmp_aarch64_simd, (arg->_hwcap & HWCAP_ASIMD) && !(arg->_hwcap2 & HWCAP2_MTE));
+    IFUNC_VARIANT(wcsncmp_func, "freebsd", wcsncmp_freebsd, true);
+}
+
+typedef wchar_t* wmemchr_func(const wchar_t* __src, wchar_t __wc, size_t __n);
+DEFINE_IFUNC_VARIANTS(wmemchr) {
+    IFUNC_VARIANT(wmemchr_func, "simd", __wmemchr_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(wmemchr_func, "freebsd", wmemchr_freebsd, true);
+}
+
+typedef int wmemcmp_func(const wchar_t* __lhs, const wchar_t* __rhs, size_t __n);
+DEFINE_IFUNC_VARIANTS(wmemcmp) {
+    IFUNC_VARIANT(wmemcmp_func, "simd", __wmemcmp_aarch64_simd, arg->_hwcap & HWCAP_ASIMD);
+    IFUNC_VARIANT(wmemcmp_func, "freebsd", wmemcmp_freebsd, true);
+}
+
+const IfuncVariantTableEntry __bionic_ifunc_variant_table[] = {
+    IFUNC_VARIANT_TABLE_ENTRY(memchr),
+    IFUNC_VARIANT_TABLE_ENTRY(memcmp),
+    IFUNC_VARIANT_TABLE_ENTRY(memcpy),
+    IFUNC_VARIANT_TABLE_ENTRY(memmem),
+    IFUNC_VARIANT_TABLE_ENTRY(memmove),
+    IFUNC_VARIANT_TABLE_ENTRY(stpcpy),
+    IFUNC_VARIANT_TABLE_ENTRY(strcasestr),
+    IFUNC_VARIANT_TABLE_ENTRY(strchr),
+    IFUNC_VARIANT_TABLE_ENTRY(strchrnul),
+    IFUNC_VARIANT_TABLE_ENTRY(strcmp),
+    IFUNC_VARIANT_TABLE_ENTRY(strcpy),
+    IFUNC_VARIANT_TABLE_ENTRY(strcspn),
+    IFUNC_VARIANT_TABLE_ENTRY(strlen),
+    IFUNC_VARIANT_TABLE_ENTRY(strncmp),
+    IFUNC_VARIANT_TABLE_ENTRY(strnlen),
+    IFUNC_VARIANT_TABLE_ENTRY(strpbrk),
+    IFUNC_VARIANT_TABLE_ENTRY(strrchr),
+    IFUNC_VARIANT_TABLE_ENTRY(strspn),
+    IFUNC_VARIANT_TABLE_ENTRY(strstr),
+    IFUNC_VARIANT_TABLE_ENTRY(wcschr),
+    IFUNC_VARIANT_TABLE_ENTRY(wcscmp),
+    IFUNC_VARIANT_TABLE_ENTRY(wcslen),
+    IFUNC_VARIANT_TABLE_ENTRY(wcsncmp),
+    IFUNC_VARIANT_TABLE_ENTRY(wmemchr),
+    IFUNC_VARIANT_TABLE_ENTRY(wmemcmp),
+    {},
+};
+
 }  // extern "C"
@@ -63,7 +63,7 @@ DEFINE_IFUNC_FOR(memmove) {
 
 typedef void* memcpy_func(void*, const void*, size_t);
 DEFINE_IFUNC_FOR(memcpy) {
-    return memmove_resolver();
+    return memmove_resolver(ifunc_overrides);
 }
 
 typedef char* strcpy_func(char* __dst, const char* __src);
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <cpuid.h>
+#include <stddef.h>
+
+#include "private/bionic_globals.h"
+
+static_assert(offsetof(libc_globals, cache_info) == 0,
+              "cache_info must be at the start of libc_globals");
+static_assert(offsetof(x86_64_cache_info, data_cache_size) == X86_64_CACHE_INFO_DATA_CACHE_SIZE);
+static_assert(offsetof(x86_64_cache_info, data_cache_size_half) ==
+              X86_64_CACHE_INFO_DATA_CACHE_SIZE_HALF);
+static_assert(offsetof(x86_64_cache_info, shared_cache_size) ==
+              X86_64_CACHE_INFO_SHARED_CACHE_SIZE);
+static_assert(offsetof(x86_64_cache_info, shared_cache_size_half) ==
+              X86_64_CACHE_INFO_SHARED_CACHE_SIZE_HALF);
+
+struct cache_sizes {
+  size_t l1d;
+  size_t l2;
+  size_t l3;
+};
+
+// Intel's leaf 4 and AMD's leaf 0x8000001d both use the same "deterministic
+// cache parameters" layout: one subleaf per cache, terminated by type 0.
+static void read_deterministic_cache_params(unsigned leaf, cache_sizes* sizes) {
+  for (unsigned i = 0; i < 16; ++i) {
+    unsigned eax, ebx, ecx, edx;
+    __cpuid_count(leaf, i, eax, ebx, ecx, edx);
+    unsigned type = eax & 0x1f;
+    if (type == 0) {
+      break;
+    }
+    // Skip instruction caches (type 2); we only care about data and unified caches.
+    if (type == 2) {
+      continue;
+    }
+
+    unsigned level = (eax >> 5) & 0x7;
+    size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+    size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+    size_t line_size = (ebx & 0xfff) + 1;
+    size_t sets = static_cast<size_t>(ecx) + 1;
+    size_t size = ways * partitions * line_size * sets;
+
+    if (level == 1) {
+      sizes->l1d = size;
+    } else if (level == 2) {
+      sizes->l2 = size;
+    } else if (level == 3) {
+      sizes->l3 = size;
+    }
+  }
+}
+
+static void read_cache_sizes(cache_sizes* sizes) {
+  unsigned max_leaf, ebx, ecx, edx;
+  __cpuid(0, max_leaf, ebx, ecx, edx);
+  if (max_leaf >= 4) {
+    read_deterministic_cache_params(4, sizes);
+    if (sizes->l1d != 0) {
+      return;
+    }
+  }
+
+  unsigned max_extended_leaf;
+  __cpuid(0x80000000, max_extended_leaf, ebx, ecx, edx);
+  if (max_extended_leaf >= 0x8000001d) {
+    // Only valid if the TopologyExtensions bit is set.
+    unsigned eax;
+    __cpuid(0x80000001, eax, ebx, ecx, edx);
+    if (ecx & (1 << 22)) {
+      read_deterministic_cache_params(0x8000001d, sizes);
+      if (sizes->l1d != 0) {
+        return;
+      }
+    }
+  }
+
+  // Older AMD CPUs only describe their caches in the legacy extended leaves.
+  if (max_extended_leaf >= 0x80000005) {
+    unsigned eax;
+    __cpuid(0x80000005, eax, ebx, ecx, edx);
+    sizes->l1d = static_cast<size_t>(ecx >> 24) * 1024;
+  }
+  if (max_extended_leaf >= 0x80000006) {
+    unsigned eax;
+    __cpuid(0x80000006, eax, ebx, ecx, edx);
+    sizes->l2 = static_cast<size_t>(ecx >> 16) * 1024;
+    sizes->l3 = static_cast<size_t>(edx >> 18) * 512 * 1024;
+  }
+}
+
+void __libc_init_x86_64_cache_info(libc_globals* globals) {
+  cache_sizes sizes = {};
+  read_cache_sizes(&sizes);
+
+  size_t data = sizes.l1d;
+  // The "shared" cache is the last level cache: L3 where there is one, L2
+  // on parts like Atom where the L2 is shared between cores.
+  size_t shared = sizes.l3 != 0 ? sizes.l3 : sizes.l2;
+  if (data == 0) {
+    data = X86_64_DEFAULT_DATA_CACHE_SIZE;
+  }
+  if (shared == 0) {
+    shared = X86_64_DEFAULT_SHARED_CACHE_SIZE;
+  }
+
+  x86_64_cache_info* info = &globals->cache_info;
+  info->data_cache_size = data;
+  info->data_cache_size_half = data / 2;
+  info->shared_cache_size = shared;
+  info->shared_cache_size_half = shared / 2;
+}
@@ -26,24 +26,236 @@
  * SUCH DAMAGE.
  */
 
+#include <cpuid.h>
 #include <stddef.h>
 
 #include <private/bionic_ifuncs.h>
 
+// __builtin_cpu_supports() doesn't know about ERMS or FSRM, so we ask CPUID ourselves.
+static bool cpu_supports_fast_rep_movsb() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+  constexpr unsigned int kErms = 1u << 9;  // ebx
+  constexpr unsigned int kFsrm = 1u << 4;  // edx
+  return (ebx & kErms) != 0 || (edx & kFsrm) != 0;
+}
+
 extern "C" {
 
 typedef int memset_func(void* __dst, int __ch, size_t __n);
-DEFINE_IFUNC_FOR(memset) {
+DEFINE_IFUNC_VARIANTS(memset) {
   __builtin_cpu_init();
-  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(memset_func, memset_avx2);
-  RETURN_FUNC(memset_func, memset_generic);
+  IFUNC_VARIANT(memset_func, "avx2", memset_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(memset_func, "generic", memset_generic, true);
 }
 
 typedef void* __memset_chk_func(void* s, int c, size_t n, size_t n2);
-DEFINE_IFUNC_FOR(__memset_chk) {
+DEFINE_IFUNC_VARIANTS(__memset_chk) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(__memset_chk_func, "avx2", __memset_chk_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(__memset_chk_func, "generic", __memset_chk_generic, true);
+}
+
+typedef void* memmove_func(void* __dst, const void* __src, size_t __n);
+DEFINE_IFUNC_VARIANTS(memmove) {
+  __builtin_cpu_init();
+  bool erms = cpu_supports_fast_rep_movsb();
+  bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl");
+  bool avx2 = __builtin_cpu_supports("avx2");
+  IFUNC_VARIANT(memmove_func, "avx512_erms", memmove_avx512_erms, avx512 && erms);
+  IFUNC_VARIANT(memmove_func, "avx512", memmove_avx512, avx512);
+  IFUNC_VARIANT(memmove_func, "avx2_erms", memmove_avx2_erms, avx2 && erms);
+  IFUNC_VARIANT(memmove_func, "avx2", memmove_avx2, avx2);
+  IFUNC_VARIANT(memmove_func, "generic", memmove_generic, true);
+}
+
+typedef void* memcpy_func(void*, const void*, size_t);
+DEFINE_IFUNC_VARIANTS(memcpy) {
+  memmove_variants(visitor);
+}
+
+typedef void* memchr_func(const void* __s, int __ch, size_t __n);
+DEFINE_IFUNC_VARIANTS(memchr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(memchr_func, "avx2", memchr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(memchr_func, "openbsd", memchr_openbsd, true);
+}
+
+typedef int memcmp_func(const void* __lhs, const void* __rhs, size_t __n);
+DEFINE_IFUNC_VARIANTS(memcmp) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(memcmp_func, "avx2", memcmp_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(memcmp_func, "generic", memcmp_generic, true);
+}
+
+typedef void* memmem_func(const void* __haystack, size_t __haystack_size, const void* __needle, size_t __needle_size);
+DEFINE_IFUNC_VARIANTS(memmem) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(memmem_func, "avx2", memmem_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(memmem_func, "sse2", memmem_sse2, true);
+}
+
+typedef char* strcasestr_func(const char* __haystack, const char* __needle);
+DEFINE_IFUNC_VARIANTS(strcasestr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strcasestr_func, "avx2", strcasestr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strcasestr_func, "sse2", strcasestr_sse2, true);
+}
+
+typedef char* strchr_func(const char* __s, int __ch);
+DEFINE_IFUNC_VARIANTS(strchr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strchr_func, "avx2", strchr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strchr_func, "generic", strchr_generic, true);
+}
+
+typedef int strcmp_func(const char* __lhs, const char* __rhs);
+DEFINE_IFUNC_VARIANTS(strcmp) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strcmp_func, "avx2", strcmp_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strcmp_func, "generic", strcmp_generic, true);
+}
+
+typedef size_t strcspn_func(const char* __s, const char* __reject);
+DEFINE_IFUNC_VARIANTS(strcspn) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strcspn_func, "avx2", strcspn_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strcspn_func, "ssse3", strcspn_ssse3, true);
+}
+
+typedef size_t strlen_func(const char* __s);
+DEFINE_IFUNC_VARIANTS(strlen) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strlen_func, "avx2", strlen_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strlen_func, "generic", strlen_generic, true);
+}
+
+typedef int strncmp_func(const char* __lhs, const char* __rhs, size_t __n);
+DEFINE_IFUNC_VARIANTS(strncmp) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strncmp_func, "avx2", strncmp_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strncmp_func, "generic", strncmp_generic, true);
+}
+
+typedef size_t strnlen_func(const char* __s, size_t __n);
+DEFINE_IFUNC_VARIANTS(strnlen) {
   __builtin_cpu_init();
-  if (__builtin_cpu_supports("avx2")) RETURN_FUNC(__memset_chk_func, __memset_chk_avx2);
-  RETURN_FUNC(__memset_chk_func, __memset_chk_generic);
+  IFUNC_VARIANT(strnlen_func, "avx2", strnlen_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strnlen_func, "generic", strnlen_generic, true);
 }
 
+typedef char* strpbrk_func(const char* __s, const char* __accept);
+DEFINE_IFUNC_VARIANTS(strpbrk) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strpbrk_func, "avx2", strpbrk_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strpbrk_func, "ssse3", strpbrk_ssse3, true);
+}
+
+typedef char* strrchr_func(const char* __s, int __ch);
+DEFINE_IFUNC_VARIANTS(strrchr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strrchr_func, "avx2", strrchr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strrchr_func, "generic", strrchr_generic, true);
+}
+
+typedef size_t strspn_func(const char* __s, const char* __accept);
+DEFINE_IFUNC_VARIANTS(strspn) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strspn_func, "avx2", strspn_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strspn_func, "ssse3", strspn_ssse3, true);
+}
+
+typedef char* strstr_func(const char* __haystack, const char* __needle);
+DEFINE_IFUNC_VARIANTS(strstr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(strstr_func, "avx2", strstr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(strstr_func, "sse2", strstr_sse2, true);
+}
+
+typedef wchar_t* wcschr_func(const wchar_t* __s, wchar_t __wc);
+DEFINE_IFUNC_VARIANTS(wcschr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wcschr_func, "avx2", wcschr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wcschr_func, "freebsd", wcschr_freebsd, true);
+}
+
+typedef int wcscmp_func(const wchar_t* __lhs, const wchar_t* __rhs);
+DEFINE_IFUNC_VARIANTS(wcscmp) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wcscmp_func, "avx2", wcscmp_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wcscmp_func, "freebsd", wcscmp_freebsd, true);
+}
+
+typedef size_t wcslen_func(const wchar_t* __s);
+DEFINE_IFUNC_VARIANTS(wcslen) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wcslen_func, "avx2", wcslen_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wcslen_func, "freebsd", wcslen_freebsd, true);
+}
+
+typedef int wcsncmp_func(const wchar_t* __lhs, const wchar_t* __rhs, size_t __n);
+DEFINE_IFUNC_VARIANTS(wcsncmp) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wcsncmp_func, "avx2", wcsncmp_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wcsncmp_func, "freebsd", wcsncmp_freebsd, true);
+}
+
+typedef size_t wcsnlen_func(const wchar_t* __s, size_t __n);
+DEFINE_IFUNC_VARIANTS(wcsnlen) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wcsnlen_func, "avx2", wcsnlen_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wcsnlen_func, "freebsd", wcsnlen_freebsd, true);
+}
+
+typedef wchar_t* wcsrchr_func(const wchar_t* __s, wchar_t __wc);
+DEFINE_IFUNC_VARIANTS(wcsrchr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wcsrchr_func, "avx2", wcsrchr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wcsrchr_func, "freebsd", wcsrchr_freebsd, true);
+}
+
+typedef wchar_t* wmemchr_func(const wchar_t* __src, wchar_t __wc, size_t __n);
+DEFINE_IFUNC_VARIANTS(wmemchr) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wmemchr_func, "avx2", wmemchr_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wmemchr_func, "freebsd", wmemchr_freebsd, true);
+}
+
+typedef int wmemcmp_func(const wchar_t* __lhs, const wchar_t* __rhs, size_t __n);
+DEFINE_IFUNC_VARIANTS(wmemcmp) {
+  __builtin_cpu_init();
+  IFUNC_VARIANT(wmemcmp_func, "avx2", wmemcmp_avx2, __builtin_cpu_supports("avx2"));
+  IFUNC_VARIANT(wmemcmp_func, "freebsd", wmemcmp_freebsd, true);
+}
+
+const IfuncVariantTableEntry __bionic_ifunc_variant_table[] = {
+    IFUNC_VARIANT_TABLE_ENTRY(__memset_chk),
+    IFUNC_VARIANT_TABLE_ENTRY(memchr),
+    IFUNC_VARIANT_TABLE_ENTRY(memcmp),
+    IFUNC_VARIANT_TABLE_ENTRY(memcpy),
+    IFUNC_VARIANT_TABLE_ENTRY(memmem),
+    IFUNC_VARIANT_TABLE_ENTRY(memmove),
+    IFUNC_VARIANT_TABLE_ENTRY(memset),
+    IFUNC_VARIANT_TABLE_ENTRY(strcasestr),
+    IFUNC_VARIANT_TABLE_ENTRY(strchr),
+    IFUNC_VARIANT_TABLE_ENTRY(strcmp),
+    IFUNC_VARIANT_TABLE_ENTRY(strcspn),
+    IFUNC_VARIANT_TABLE_ENTRY(strlen),
+    IFUNC_VARIANT_TABLE_ENTRY(strncmp),
+    IFUNC_VARIANT_TABLE_ENTRY(strnlen),
+    IFUNC_VARIANT_TABLE_ENTRY(strpbrk),
+    IFUNC_VARIANT_TABLE_ENTRY(strrchr),
+    IFUNC_VARIANT_TABLE_ENTRY(strspn),
+    IFUNC_VARIANT_TABLE_ENTRY(strstr),
+    IFUNC_VARIANT_TABLE_ENTRY(wcschr),
+    IFUNC_VARIANT_TABLE_ENTRY(wcscmp),
+    IFUNC_VARIANT_TABLE_ENTRY(wcslen),
+    IFUNC_VARIANT_TABLE_ENTRY(wcsncmp),
+    IFUNC_VARIANT_TABLE_ENTRY(wcsnlen),
+    IFUNC_VARIANT_TABLE_ENTRY(wcsrchr),
+    IFUNC_VARIANT_TABLE_ENTRY(wmemchr),
+    IFUNC_VARIANT_TABLE_ENTRY(wmemcmp),
+    {},
+};
+
 }  // extern "C"
@@ -28,9 +28,15 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-/* Values are optimized for Core Architecture */
-#define SHARED_CACHE_SIZE (4096*1024)  /* Core Architecture L2 Cache */
-#define DATA_CACHE_SIZE   (24*1024)    /* Core Architecture L1 Data Cache */
+/*
+ * Cache sizes are detected from CPUID at startup and stored at the start of
+ * __libc_globals (see private/bionic_x86_64_cache_info.h). Defining
+ * SHARED_CACHE_SIZE/DATA_CACHE_SIZE (and their _HALF variants) before
+ * including this file pins the old compile-time values instead.
+ */
+#include <private/bionic_x86_64_cache_info.h>
 
-#define SHARED_CACHE_SIZE_HALF (SHARED_CACHE_SIZE / 2)
-#define DATA_CACHE_SIZE_HALF   (DATA_CACHE_SIZE / 2)
+#define __x86_64_data_cache_size __libc_globals+X86_64_CACHE_INFO_DATA_CACHE_SIZE
+#define __x86_64_data_cache_size_half __libc_globals+X86_64_CACHE_INFO_DATA_CACHE_SIZE_HALF
+#define __x86_64_shared_cache_size __libc_globals+X86_64_CACHE_INFO_SHARED_CACHE_SIZE
+#define __x86_64_shared_cache_size_half __libc_globals+X86_64_CACHE_INFO_SHARED_CACHE_SIZE_HALF
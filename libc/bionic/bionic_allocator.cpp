@@ -61,6 +61,11 @@
 // the block to free_blocks_list in the corresponding page. If the number of
 // free pages reaches 2, BionicSmallObjectAllocator munmaps one of the pages
 // keeping the other one in reserve.
+//
+// The allocator itself is not thread-safe. Callers that share one between
+// threads (the dynamic TLS allocator) instead use the overloads taking a
+// BionicAllocatorCache: each thread keeps a few free blocks per size class and
+// only takes the allocator's lock to refill or drain half a list at a time.
 
 // Memory management for large objects is fairly straightforward, but for small
 // objects it is more complicated.  If you are changing this code, one simple
@@ -79,6 +84,15 @@ static const size_t kSmallObjectMaxSize = 1 << kSmallObjectMaxSizeLog2;
 // This type is used for large allocations (with size >1k)
 static const uint32_t kLargeObject = 111;
 
+// Each per-thread cache list holds at most this many bytes, and at most
+// kCacheMaxBlocks blocks, so a thread never pins more than a few KiB.
+static constexpr size_t kCacheBytesPerClass = 1024;
+static constexpr size_t kCacheMaxBlocks = 16;
+
+static inline size_t cache_capacity(uint32_t type) {
+  return MAX(1, MIN(kCacheMaxBlocks, kCacheBytesPerClass >> type));
+}
+
 // Allocated pointers must be at least 16-byte aligned.  Round up the size of
 // page_info to multiple of 16.
 static constexpr size_t kPageInfoSize = __BIONIC_ALIGN(sizeof(page_info), 16);
@@ -292,9 +306,11 @@ void* BionicAllocator::alloc_mmap(size_t align, size_t size) {
 }
 
 
-inline void* BionicAllocator::alloc_impl(size_t align, size_t size) {
+// Returns the small object type (log2 of the block size) for an allocation,
+// or 0 if it needs a large object.
+inline uint32_t BionicAllocator::small_object_type(size_t size) {
   if (size > kSmallObjectMaxSize) {
-    return alloc_mmap(align, size);
+    return 0;
   }
 
   uint16_t log2_size = log2(size);
@@ -303,7 +319,16 @@ inline void* BionicAllocator::alloc_impl(size_t align, size_t size) {
     log2_size = kSmallObjectMinSizeLog2;
   }
 
-  return get_small_object_allocator(log2_size)->alloc();
+  return log2_size;
+}
+
+inline void* BionicAllocator::alloc_impl(size_t align, size_t size) {
+  uint32_t type = small_object_type(size);
+  if (type == 0) {
+    return alloc_mmap(align, size);
+  }
+
+  return get_small_object_allocator(type)->alloc();
 }
 
 void* BionicAllocator::alloc(size_t size) {
@@ -314,18 +339,116 @@ void* BionicAllocator::alloc(size_t size) {
   return alloc_impl(16, size);
 }
 
-void* BionicAllocator::memalign(size_t align, size_t size) {
+static inline void adjust_memalign_args(size_t* align, size_t* size) {
   // The Bionic allocator only supports alignment up to one page, which is good
   // enough for ELF TLS.
-  align = MIN(align, PAGE_SIZE);
-  align = MAX(align, 16);
-  if (!powerof2(align)) {
-    align = BIONIC_ROUND_UP_POWER_OF_2(align);
+  *align = MIN(*align, PAGE_SIZE);
+  *align = MAX(*align, 16);
+  if (!powerof2(*align)) {
+    *align = BIONIC_ROUND_UP_POWER_OF_2(*align);
   }
-  size = MAX(size, align);
+  *size = MAX(*size, *align);
+}
+
+void* BionicAllocator::memalign(size_t align, size_t size) {
+  adjust_memalign_args(&align, &size);
   return alloc_impl(align, size);
 }
 
+void* BionicAllocator::alloc(size_t size, BionicAllocatorCache* cache) {
+  // treat alloc(0) as alloc(1)
+  if (size == 0) {
+    size = 1;
+  }
+  return alloc_cached(16, size, cache);
+}
+
+void* BionicAllocator::memalign(size_t align, size_t size, BionicAllocatorCache* cache) {
+  adjust_memalign_args(&align, &size);
+  return alloc_cached(align, size, cache);
+}
+
+void* BionicAllocator::alloc_cached(size_t align, size_t size, BionicAllocatorCache* cache) {
+  uint32_t type = small_object_type(size);
+  if (type == 0) {
+    // Large objects are mapped directly and share no state.
+    return alloc_mmap(align, size);
+  }
+
+  const size_t idx = type - kSmallObjectMinSizeLog2;
+  if (cache->free_lists[idx] == nullptr) {
+    LockGuard guard(lock_);
+    BionicSmallObjectAllocator* allocator = get_small_object_allocator(type);
+    const size_t refill = MAX(1, cache_capacity(type) / 2);
+    while (cache->counts[idx] < refill) {
+      small_object_block_record* block =
+          static_cast<small_object_block_record*>(allocator->alloc());
+      block->next = cache->free_lists[idx];
+      cache->free_lists[idx] = block;
+      cache->counts[idx]++;
+    }
+  }
+
+  small_object_block_record* block = cache->free_lists[idx];
+  cache->free_lists[idx] = block->next;
+  cache->counts[idx]--;
+  memset(block, 0, 1 << type);
+  return block;
+}
+
+void BionicAllocator::free(void* ptr, BionicAllocatorCache* cache) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  page_info* info = get_page_info(ptr);
+
+  if (info->type == kLargeObject) {
+    munmap(info, info->allocated_size);
+    return;
+  }
+
+  BionicSmallObjectAllocator* allocator = get_small_object_allocator(info->type);
+  if (allocator != info->allocator_addr) {
+    async_safe_fatal("invalid pointer %p (invalid allocator address for the page)", ptr);
+  }
+  if (reinterpret_cast<uintptr_t>(ptr) % allocator->get_block_size() != 0) {
+    async_safe_fatal("invalid pointer: %p (block_size=%zd)", ptr, allocator->get_block_size());
+  }
+
+  const size_t idx = info->type - kSmallObjectMinSizeLog2;
+  if (cache->counts[idx] == cache_capacity(info->type)) {
+    drain_cache_list(cache, info->type, cache->counts[idx] / 2);
+  }
+
+  small_object_block_record* block = static_cast<small_object_block_record*>(ptr);
+  block->next = cache->free_lists[idx];
+  cache->free_lists[idx] = block;
+  cache->counts[idx]++;
+}
+
+void BionicAllocator::flush_cache(BionicAllocatorCache* cache) {
+  for (uint32_t type = kSmallObjectMinSizeLog2; type <= kSmallObjectMaxSizeLog2; ++type) {
+    if (cache->counts[type - kSmallObjectMinSizeLog2] != 0) {
+      drain_cache_list(cache, type, 0);
+    }
+  }
+}
+
+// Returns blocks from one of the cache's lists to the allocator until only
+// `keep` are left.
+void BionicAllocator::drain_cache_list(BionicAllocatorCache* cache, uint32_t type, size_t keep) {
+  const size_t idx = type - kSmallObjectMinSizeLog2;
+  LockGuard guard(lock_);
+  BionicSmallObjectAllocator* allocator = get_small_object_allocator(type);
+  while (cache->counts[idx] > keep) {
+    small_object_block_record* block = cache->free_lists[idx];
+    cache->free_lists[idx] = block->next;
+    cache->counts[idx]--;
+    allocator->free(block);
+  }
+}
+
 inline page_info* BionicAllocator::get_page_info_unchecked(void* ptr) {
   uintptr_t header_page = PAGE_START(reinterpret_cast<size_t>(ptr) - kPageInfoSize);
   return reinterpret_cast<page_info*>(header_page);
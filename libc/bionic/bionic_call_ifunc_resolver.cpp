@@ -30,15 +30,36 @@
 #include <sys/auxv.h>
 #include <sys/ifunc.h>
 
+#include "platform/bionic/ifunc.h"
 #include "private/bionic_auxv.h"
+#include "private/bionic_globals.h"
 
 // This code is called in the linker before it has been relocated, so minimize calls into other
 // parts of Bionic. In particular, we won't ever have two ifunc resolvers called concurrently, so
 // initializing the ifunc resolver argument doesn't need to be thread-safe.
 
+// Returns the value of LIBC_IFUNC_OVERRIDE, or null. This isn't cached because the linker resolves
+// its own ifuncs before the environment is available. (It's already been sanitized for AT_SECURE
+// processes by the time libc's resolvers are called.)
+static const char* ifunc_overrides() {
+  char** env = __libc_shared_globals()->init_environ;
+  if (env == nullptr) return nullptr;
+  for (; *env != nullptr; ++env) {
+    const char* name = ANDROID_IFUNC_OVERRIDE_ENV;
+    const char* p = *env;
+    while (*name != '\0' && *p == *name) {
+      ++p;
+      ++name;
+    }
+    if (*name == '\0' && *p == '=') return p + 1;
+  }
+  return nullptr;
+}
+
 ElfW(Addr) __bionic_call_ifunc_resolver(ElfW(Addr) resolver_addr) {
+  const char* overrides = ifunc_overrides();
 #if defined(__aarch64__)
-  typedef ElfW(Addr) (*ifunc_resolver_t)(uint64_t, __ifunc_arg_t*);
+  typedef ElfW(Addr) (*ifunc_resolver_t)(uint64_t, __ifunc_arg_t*, const char*);
   static __ifunc_arg_t arg;
   static bool initialized = false;
   if (!initialized) {
@@ -47,18 +68,19 @@ ElfW(Addr) __bionic_call_ifunc_resolver(ElfW(Addr) resolver_addr) {
     arg._hwcap = getauxval(AT_HWCAP);
     arg._hwcap2 = getauxval(AT_HWCAP2);
   }
-  return reinterpret_cast<ifunc_resolver_t>(resolver_addr)(arg._hwcap | _IFUNC_ARG_HWCAP, &arg);
+  return reinterpret_cast<ifunc_resolver_t>(resolver_addr)(arg._hwcap | _IFUNC_ARG_HWCAP, &arg,
+                                                          overrides);
 #elif defined(__arm__)
-  typedef ElfW(Addr) (*ifunc_resolver_t)(unsigned long);
+  typedef ElfW(Addr) (*ifunc_resolver_t)(unsigned long, const char*);
   static unsigned long hwcap;
   static bool initialized = false;
   if (!initialized) {
     initialized = true;
     hwcap = getauxval(AT_HWCAP);
   }
-  return reinterpret_cast<ifunc_resolver_t>(resolver_addr)(hwcap);
+  return reinterpret_cast<ifunc_resolver_t>(resolver_addr)(hwcap, overrides);
 #else
-  typedef ElfW(Addr) (*ifunc_resolver_t)(void);
-  return reinterpret_cast<ifunc_resolver_t>(resolver_addr)();
+  typedef ElfW(Addr) (*ifunc_resolver_t)(const char*);
+  return reinterpret_cast<ifunc_resolver_t>(resolver_addr)(overrides);
 #endif
 }
@@ -231,11 +231,13 @@ static size_t calculate_new_dtv_count() {
   return (bytes - sizeof(TlsDtv)) / sizeof(void*);
 }
 
-// This function must be called with signals blocked and a write lock on
-// TlsModules held.
+// This function must be called with signals blocked and a read lock on
+// TlsModules held. The TLS allocator is only used through the thread's cache,
+// which does its own locking.
 static void update_tls_dtv(bionic_tcb* tcb) {
   const TlsModules& modules = __libc_shared_globals()->tls_modules;
   BionicAllocator& allocator = __libc_shared_globals()->tls_allocator;
+  BionicAllocatorCache* cache = &tcb->thread()->tls_allocator_cache;
 
   // Use the generation counter from the shared globals instead of the local
   // copy, which won't be initialized yet if __tls_get_addr is called before
@@ -254,7 +256,7 @@ static void update_tls_dtv(bionic_tcb* tcb) {
   if (modules.module_count > old_cnt) {
     size_t new_cnt = calculate_new_dtv_count();
     TlsDtv* const old_dtv = __get_tcb_dtv(tcb);
-    TlsDtv* const new_dtv = static_cast<TlsDtv*>(allocator.alloc(dtv_size_in_bytes(new_cnt)));
+    TlsDtv* const new_dtv = static_cast<TlsDtv*>(allocator.alloc(dtv_size_in_bytes(new_cnt), cache));
     memcpy(new_dtv, old_dtv, dtv_size_in_bytes(old_cnt));
     new_dtv->count = new_cnt;
     new_dtv->next = old_dtv;
@@ -285,7 +287,7 @@ static void update_tls_dtv(bionic_tcb* tcb) {
           static_cast<void*>(static_cast<char*>(dtls_begin) + allocator.get_chunk_size(dtls_begin));
       modules.on_destruction_cb(dtls_begin, dtls_end);
     }
-    allocator.free(dtv->modules[i]);
+    allocator.free(dtv->modules[i], cache);
     dtv->modules[i] = nullptr;
   }
 
@@ -296,10 +298,11 @@ __attribute__((noinline)) static void* tls_get_addr_slow_path(const TlsIndex* ti
   TlsModules& modules = __libc_shared_globals()->tls_modules;
   bionic_tcb* tcb = __get_bionic_tcb();
 
-  // Block signals and lock TlsModules. We may need the allocator, so take
-  // a write lock.
+  // Block signals and lock TlsModules. The allocator has its own lock, so a
+  // read lock is enough, and threads touching a new module's TLS for the first
+  // time don't serialize here.
   ScopedSignalBlocker ssb;
-  ScopedWriteLock locker(&modules.rwlock);
+  ScopedReadLock locker(&modules.rwlock);
 
   update_tls_dtv(tcb);
 
@@ -308,7 +311,8 @@ __attribute__((noinline)) static void* tls_get_addr_slow_path(const TlsIndex* ti
   void* mod_ptr = dtv->modules[module_idx];
   if (mod_ptr == nullptr) {
     const TlsSegment& segment = modules.module_table[module_idx].segment;
-    mod_ptr = __libc_shared_globals()->tls_allocator.memalign(segment.alignment, segment.size);
+    mod_ptr = __libc_shared_globals()->tls_allocator.memalign(segment.alignment, segment.size,
+                                                              &tcb->thread()->tls_allocator_cache);
     if (segment.init_size > 0) {
       memcpy(mod_ptr, segment.init_ptr, segment.init_size);
     }
@@ -351,21 +355,23 @@ extern "C" void* TLS_GET_ADDR(const TlsIndex* ti) TLS_GET_ADDR_CCONV {
 // This function frees:
 //  - TLS modules referenced by the current DTV.
 //  - The list of DTV objects associated with the current thread.
+//  - The blocks in the thread's TLS allocator cache.
 //
 // The caller must have already blocked signals.
 void __free_dynamic_tls(bionic_tcb* tcb) {
   TlsModules& modules = __libc_shared_globals()->tls_modules;
   BionicAllocator& allocator = __libc_shared_globals()->tls_allocator;
+  BionicAllocatorCache* cache = &tcb->thread()->tls_allocator_cache;
 
   // If we didn't allocate any dynamic memory, skip out early without taking
   // the lock.
   TlsDtv* dtv = __get_tcb_dtv(tcb);
   if (dtv->generation == kTlsGenerationNone) {
+    allocator.flush_cache(cache);
     return;
   }
 
-  // We need the write lock to use the allocator.
-  ScopedWriteLock locker(&modules.rwlock);
+  ScopedReadLock locker(&modules.rwlock);
 
   // First free everything in the current DTV.
   for (size_t i = 0; i < dtv->count; ++i) {
@@ -381,16 +387,19 @@ void __free_dynamic_tls(bionic_tcb* tcb) {
       modules.on_destruction_cb(dtls_begin, dtls_end);
     }
 
-    allocator.free(dtv->modules[i]);
+    allocator.free(dtv->modules[i], cache);
   }
 
   // Now free the thread's list of DTVs.
   while (dtv->generation != kTlsGenerationNone) {
     TlsDtv* next = dtv->next;
-    allocator.free(dtv);
+    allocator.free(dtv, cache);
     dtv = next;
   }
 
+  // Give the thread's cached blocks back for other threads to use.
+  allocator.flush_cache(cache);
+
   // Clear the DTV slot. The DTV must not be used again with this thread.
   tcb->tls_slot(TLS_SLOT_DTV) = nullptr;
 }
@@ -35,6 +35,7 @@
 #include "pthread_internal.h"
 
 #include "private/bionic_defs.h"
+#include "private/thread_private.h"
 #include "platform/bionic/macros.h"
 
 extern "C" pid_t __bionic_clone(uint32_t flags, void* child_stack, int* parent_tid, void* tls, int* child_tid, int (*fn)(void*), void* arg);
@@ -97,6 +98,12 @@ int clone(int (*fn)(void*), void* child_stack, int flags, void* arg, ...) {
     self->tid = -1;
   }
 
+  // A child sharing our address space is a thread as far as the rest of libc
+  // is concerned, whether or not it came from pthread_create.
+  if ((flags & CLONE_VM) && !(flags & CLONE_VFORK) && !__libc_multithreaded) {
+    __libc_multithreaded = true;
+  }
+
   // Actually do the clone.
   int clone_result;
   if (fn != nullptr) {
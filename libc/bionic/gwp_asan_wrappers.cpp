@@ -90,6 +90,22 @@ void gwp_asan_free(void* mem) {
   prev_dispatch->free(mem);
 }
 
+void gwp_asan_free_sized(void* mem, size_t size) {
+  if (__predict_false(GuardedAlloc.pointerIsMine(mem))) {
+    GuardedAlloc.deallocate(mem);
+    return;
+  }
+  DispatchFreeSized(prev_dispatch, mem, size);
+}
+
+void gwp_asan_free_aligned_sized(void* mem, size_t alignment, size_t size) {
+  if (__predict_false(GuardedAlloc.pointerIsMine(mem))) {
+    GuardedAlloc.deallocate(mem);
+    return;
+  }
+  DispatchFreeAlignedSized(prev_dispatch, mem, alignment, size);
+}
+
 void* gwp_asan_malloc(size_t bytes) {
   if (__predict_false(GuardedAlloc.shouldSample())) {
     if (void* result = GuardedAlloc.allocate(bytes)) {
@@ -170,6 +186,10 @@ const MallocDispatch gwp_asan_dispatch __attribute__((unused)) = {
     Malloc(mallopt),
     Malloc(aligned_alloc),
     Malloc(malloc_info),
+    gwp_asan_free_sized,
+    gwp_asan_free_aligned_sized,
+    nullptr,
+    nullptr,
 };
 
 bool isPowerOfTwo(uint64_t x) {
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "platform/bionic/ifunc.h"
+
+#include <string.h>
+#include <sys/auxv.h>
+
+#include "private/bionic_ifuncs.h"
+
+static const IfuncVariantTableEntry* find_entry(const char* function) {
+  if (__bionic_ifunc_variant_table == nullptr) return nullptr;
+  for (const IfuncVariantTableEntry* entry = __bionic_ifunc_variant_table; entry->name != nullptr;
+       ++entry) {
+    if (strcmp(entry->name, function) == 0) return entry;
+  }
+  return nullptr;
+}
+
+const char* android_ifunc_get_function(size_t index) {
+  if (__bionic_ifunc_variant_table == nullptr) return nullptr;
+  for (size_t i = 0; i <= index; ++i) {
+    if (__bionic_ifunc_variant_table[i].name == nullptr) return nullptr;
+  }
+  return __bionic_ifunc_variant_table[index].name;
+}
+
+size_t android_ifunc_get_variants(const char* function, android_ifunc_variant* variants,
+                                  size_t count) {
+  const IfuncVariantTableEntry* entry = find_entry(function);
+  if (entry == nullptr) return 0;
+
+  IfuncVariantVisitor visitor(variants, count);
+#if defined(__aarch64__)
+  __ifunc_arg_t arg = {sizeof(__ifunc_arg_t), getauxval(AT_HWCAP), getauxval(AT_HWCAP2)};
+  entry->variants(&visitor, arg._hwcap | _IFUNC_ARG_HWCAP, &arg);
+#elif defined(__arm__)
+  entry->variants(&visitor, getauxval(AT_HWCAP));
+#else
+  entry->variants(&visitor);
+#endif
+
+  for (size_t i = 0; i < visitor.total && i < count; ++i) {
+    variants[i].selected = (variants[i].func == entry->resolved);
+  }
+  return visitor.total;
+}
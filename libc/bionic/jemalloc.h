@@ -19,6 +19,8 @@
 #include <jemalloc/jemalloc.h>
 #include <malloc.h>  // For struct mallinfo.
 
+#include <platform/bionic/malloc.h>
+
 // Need to wrap memalign since je_memalign fails on non-power of 2 alignments.
 #define je_memalign je_memalign_round_up_boundary
 
@@ -26,11 +28,21 @@
 // that size is a multiple of alignment.
 #define je_aligned_alloc je_aligned_alloc_wrapper
 
+// Need to wrap the sized frees since je_sdallocx does not accept a size of
+// zero.
+#define je_free_sized je_free_sized_wrapper
+#define je_free_aligned_sized je_free_aligned_sized_wrapper
+
 __BEGIN_DECLS
 
 void* je_aligned_alloc_wrapper(size_t, size_t);
+void je_free_aligned_sized_wrapper(void*, size_t, size_t);
+void je_free_sized_wrapper(void*, size_t);
 int je_malloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*), void*);
 int je_mallctl(const char *name, void *oldp, size_t *oldlenp, void *newp, size_t newlen) __attribute__((nothrow));
+int je_mallctlbymib(const size_t* mib, size_t miblen, void* oldp, size_t* oldlenp, void* newp,
+                    size_t newlen) __attribute__((nothrow));
+int je_mallctlnametomib(const char* name, size_t* mibp, size_t* miblenp) __attribute__((nothrow));
 struct mallinfo je_mallinfo();
 void je_malloc_disable();
 void je_malloc_enable();
@@ -38,5 +50,6 @@ int je_malloc_info(int options, FILE* fp);
 int je_mallopt(int, int);
 void* je_memalign_round_up_boundary(size_t, size_t);
 void* je_pvalloc(size_t);
+bool je_size_class_stats(android_mallopt_size_class_stats_t*);
 
 __END_DECLS
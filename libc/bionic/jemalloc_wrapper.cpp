@@ -64,6 +64,23 @@ void* je_aligned_alloc_wrapper(size_t alignment, size_t size) {
   return je_aligned_alloc(alignment, size);
 }
 
+// sdallocx lets jemalloc skip looking up the size class of the allocation.
+// It requires a size that the allocation could have been made with, which
+// zero never is, so fall back to free for that.
+void je_free_sized_wrapper(void* ptr, size_t size) {
+  if (ptr == nullptr || size == 0) {
+    return je_free(ptr);
+  }
+  je_sdallocx(ptr, size, 0);
+}
+
+void je_free_aligned_sized_wrapper(void* ptr, size_t alignment, size_t size) {
+  if (ptr == nullptr || size == 0 || !powerof2(alignment)) {
+    return je_free(ptr);
+  }
+  je_sdallocx(ptr, size, MALLOCX_ALIGN(alignment));
+}
+
 int je_mallopt(int param, int value) {
   // The only parameter we currently understand is M_DECAY_TIME.
   if (param == M_DECAY_TIME) {
@@ -172,3 +189,115 @@ int je_malloc_info(int options, FILE* fp) {
 
   return 0;
 }
+
+// Reads a numeric mallctl value by MIB, so that the name only has to be
+// parsed once no matter how many arenas and size classes are read.
+class MallctlMib {
+ public:
+  explicit MallctlMib(const char* name) {
+    valid_ = je_mallctlnametomib(name, mib_, &len_) == 0;
+  }
+
+  // Reads the value with the first two indexes in the name replaced, e.g.
+  // the arena and bin of "stats.arenas.0.bins.0.nmalloc".
+  template <typename T>
+  bool Read(T* value, size_t index, size_t second_index = 0) {
+    if (!valid_) {
+      return false;
+    }
+    mib_[2] = index;
+    if (len_ > 4) {
+      mib_[4] = second_index;
+    }
+    size_t size = sizeof(T);
+    return je_mallctlbymib(mib_, len_, value, &size, nullptr, 0) == 0;
+  }
+
+ private:
+  size_t mib_[8];
+  size_t len_ = sizeof(mib_) / sizeof(mib_[0]);
+  bool valid_;
+};
+
+static void AddSizeClassStats(android_mallopt_size_class_stats_t* stats,
+                              const android_malloc_size_class_stats_t& entry) {
+  if (stats->num_stats < stats->max_stats) {
+    stats->stats[stats->num_stats] = entry;
+  }
+  stats->num_stats++;
+}
+
+bool je_size_class_stats(android_mallopt_size_class_stats_t* stats) {
+  // The stats mallctls return a copy made at the last epoch update.
+  uint64_t epoch = 1;
+  size_t epoch_sz = sizeof(epoch);
+  unsigned narenas;
+  unsigned nbins;
+  unsigned nlextents;
+  size_t sz = sizeof(unsigned);
+  if (je_mallctl("epoch", &epoch, &epoch_sz, &epoch, sizeof(epoch)) != 0 ||
+      je_mallctl("arenas.narenas", &narenas, &sz, nullptr, 0) != 0 ||
+      je_mallctl("arenas.nbins", &nbins, &sz, nullptr, 0) != 0 ||
+      je_mallctl("arenas.nlextents", &nlextents, &sz, nullptr, 0) != 0) {
+    errno = ENOTSUP;
+    return false;
+  }
+
+  MallctlMib bin_size("arenas.bin.0.size");
+  MallctlMib bin_nregs("arenas.bin.0.nregs");
+  MallctlMib bin_nmalloc("stats.arenas.0.bins.0.nmalloc");
+  MallctlMib bin_ndalloc("stats.arenas.0.bins.0.ndalloc");
+  MallctlMib bin_curregs("stats.arenas.0.bins.0.curregs");
+  MallctlMib bin_curslabs("stats.arenas.0.bins.0.curslabs");
+  MallctlMib lextent_size("arenas.lextent.0.size");
+  MallctlMib lextent_nmalloc("stats.arenas.0.lextents.0.nmalloc");
+  MallctlMib lextent_ndalloc("stats.arenas.0.lextents.0.ndalloc");
+  MallctlMib lextent_curlextents("stats.arenas.0.lextents.0.curlextents");
+
+  for (unsigned i = 0; i < narenas; i++) {
+    for (unsigned j = 0; j < nbins; j++) {
+      android_malloc_size_class_stats_t entry = {};
+      entry.arena = i;
+      // This fails for arenas that have not been initialized.
+      if (!bin_nmalloc.Read(&entry.num_allocs, i, j)) {
+        break;
+      }
+      if (entry.num_allocs == 0) {
+        continue;
+      }
+      uint32_t nregs;
+      size_t curregs;
+      size_t curslabs;
+      if (!bin_size.Read(&entry.size, j) || !bin_nregs.Read(&nregs, j) ||
+          !bin_ndalloc.Read(&entry.num_frees, i, j) || !bin_curregs.Read(&curregs, i, j) ||
+          !bin_curslabs.Read(&curslabs, i, j)) {
+        errno = EIO;
+        return false;
+      }
+      entry.live_bytes = curregs * entry.size;
+      entry.cached_bytes = (curslabs * nregs - curregs) * entry.size;
+      AddSizeClassStats(stats, entry);
+    }
+
+    // Large allocations get their own extents, so nothing is cached per class.
+    for (unsigned j = 0; j < nlextents; j++) {
+      android_malloc_size_class_stats_t entry = {};
+      entry.arena = i;
+      if (!lextent_nmalloc.Read(&entry.num_allocs, i, j)) {
+        break;
+      }
+      if (entry.num_allocs == 0) {
+        continue;
+      }
+      size_t curlextents;
+      if (!lextent_size.Read(&entry.size, j) || !lextent_ndalloc.Read(&entry.num_frees, i, j) ||
+          !lextent_curlextents.Read(&curlextents, i, j)) {
+        errno = EIO;
+        return false;
+      }
+      entry.live_bytes = curlextents * entry.size;
+      AddSizeClassStats(stats, entry);
+    }
+  }
+  return true;
+}
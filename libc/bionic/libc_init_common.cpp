@@ -70,6 +70,9 @@ void __libc_init_globals() {
   __libc_globals.mutate([](libc_globals* globals) {
     __libc_init_vdso(globals);
     __libc_init_setjmp_cookie(globals);
+#if defined(__x86_64__)
+    __libc_init_x86_64_cache_info(globals);
+#endif
   });
 }
 
@@ -167,6 +170,7 @@ void __libc_init_common() {
 #endif
 
   __libc_add_main_thread();
+  __libc_init_rseq();
 
   __system_properties_init(); // Requires 'environ'.
   __libc_init_fdsan(); // Requires system properties (for debug.fdsan).
@@ -180,10 +184,11 @@ void __libc_init_fork_handler() {
 
 extern "C" void scudo_malloc_set_add_large_allocation_slack(int add_slack);
 
-__BIONIC_WEAK_FOR_NATIVE_BRIDGE void __libc_set_target_sdk_version(int target __unused) {
+__BIONIC_WEAK_FOR_NATIVE_BRIDGE void __libc_set_target_sdk_version(int target) {
 #if defined(USE_SCUDO)
   scudo_malloc_set_add_large_allocation_slack(target < __ANDROID_API_S__);
 #endif
+  __rseq_set_target_sdk_version(target);
 }
 
 __noreturn static void __early_abort(int line) {
@@ -298,6 +303,7 @@ static bool __is_unsafe_environment_variable(const char* name) {
       "LD_USE_LOAD_BIAS",
       "LIBC_DEBUG_MALLOC_OPTIONS",
       "LIBC_HOOKS_ENABLE",
+      "LIBC_IFUNC_OVERRIDE",
       "LOCALDOMAIN",
       "LOCPATH",
       "MALLOC_CHECK_",
@@ -85,6 +85,74 @@ extern "C" void free(void* mem) {
   }
 }
 
+extern "C" void free_sized(void* mem, size_t size) {
+  auto dispatch_table = GetDispatchTable();
+  mem = MaybeUntagAndCheckPointer(mem);
+  if (__predict_false(dispatch_table != nullptr)) {
+    DispatchFreeSized(dispatch_table, mem, size);
+  } else {
+    Malloc(free_sized)(mem, size);
+  }
+}
+
+extern "C" void free_aligned_sized(void* mem, size_t alignment, size_t size) {
+  auto dispatch_table = GetDispatchTable();
+  mem = MaybeUntagAndCheckPointer(mem);
+  if (__predict_false(dispatch_table != nullptr)) {
+    DispatchFreeAlignedSized(dispatch_table, mem, alignment, size);
+  } else {
+    Malloc(free_aligned_sized)(mem, alignment, size);
+  }
+}
+
+// None of the native allocators have a batch interface, but looping here
+// still saves going through the dispatch checks for every object.
+static size_t NativeMallocBatch(size_t size, void** ptrs, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    ptrs[i] = Malloc(malloc)(size);
+    if (__predict_false(ptrs[i] == nullptr)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+static void NativeFreeBatch(void** ptrs, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    Malloc(free)(ptrs[i]);
+  }
+}
+
+extern "C" size_t android_malloc_batch(size_t size, void** ptrs, size_t count) {
+  auto dispatch_table = GetDispatchTable();
+  size_t allocated;
+  if (__predict_false(dispatch_table != nullptr)) {
+    allocated = DispatchMallocBatch(dispatch_table, size, ptrs, count);
+  } else {
+    allocated = NativeMallocBatch(size, ptrs, count);
+  }
+  if (__predict_false(allocated < count)) {
+    warning_log("android_malloc_batch(%zu, %zu) failed after %zu allocations", size, count,
+                allocated);
+  }
+  for (size_t i = 0; i < allocated; i++) {
+    ptrs[i] = MaybeTagPointer(ptrs[i]);
+  }
+  return allocated;
+}
+
+extern "C" void android_free_batch(void** ptrs, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    ptrs[i] = MaybeUntagAndCheckPointer(ptrs[i]);
+  }
+  auto dispatch_table = GetDispatchTable();
+  if (__predict_false(dispatch_table != nullptr)) {
+    DispatchFreeBatch(dispatch_table, ptrs, count);
+  } else {
+    NativeFreeBatch(ptrs, count);
+  }
+}
+
 extern "C" struct mallinfo mallinfo() {
   auto dispatch_table = GetDispatchTable();
   if (__predict_false(dispatch_table != nullptr)) {
@@ -314,9 +382,41 @@ extern "C" int __sanitizer_malloc_info(int, FILE*) {
   errno = ENOTSUP;
   return -1;
 }
+
+extern "C" bool __sanitizer_size_class_stats(android_mallopt_size_class_stats_t*) {
+  errno = ENOTSUP;
+  return false;
+}
 #endif
 // =============================================================================
 
+// =============================================================================
+// Shared by both android_mallopt variants. These are the native allocator's
+// counters even when a dispatch table is installed, since debug malloc and
+// the hooks still allocate from the native allocator.
+// =============================================================================
+bool GetSizeClassStats(void* arg, size_t arg_size) {
+  if (arg == nullptr || arg_size != sizeof(android_mallopt_size_class_stats_t)) {
+    errno = EINVAL;
+    return false;
+  }
+  auto stats = reinterpret_cast<android_mallopt_size_class_stats_t*>(arg);
+  if (stats->stats == nullptr && stats->max_stats != 0) {
+    errno = EINVAL;
+    return false;
+  }
+  stats->num_stats = 0;
+  if (!Malloc(size_class_stats)(stats)) {
+    return false;
+  }
+  if (stats->num_stats > stats->max_stats) {
+    errno = ENOBUFS;
+    return false;
+  }
+  return true;
+}
+// =============================================================================
+
 // =============================================================================
 // Platform-internal mallopt variant.
 // =============================================================================
@@ -341,6 +441,9 @@ extern "C" bool android_mallopt(int opcode, void* arg, size_t arg_size) {
     *reinterpret_cast<bool*>(arg) = atomic_load(&__libc_globals->memtag_stack);
     return true;
   }
+  if (opcode == M_GET_SIZE_CLASS_STATS) {
+    return GetSizeClassStats(arg, arg_size);
+  }
   errno = ENOTSUP;
   return false;
 }
@@ -368,6 +471,10 @@ static constexpr MallocDispatch __libc_malloc_default_dispatch __attribute__((un
   Malloc(mallopt),
   Malloc(aligned_alloc),
   Malloc(malloc_info),
+  Malloc(free_sized),
+  Malloc(free_aligned_sized),
+  NativeMallocBatch,
+  NativeFreeBatch,
 };
 
 const MallocDispatch* NativeAllocatorDispatch() {
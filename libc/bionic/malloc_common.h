@@ -49,6 +49,14 @@ void __sanitizer_malloc_disable();
 void __sanitizer_malloc_enable();
 int __sanitizer_malloc_info(int options, FILE* fp);
 
+// HWASan has no sized free, so these are plain frees.
+static inline void __sanitizer_free_sized(void* ptr, size_t) {
+  __sanitizer_free(ptr);
+}
+static inline void __sanitizer_free_aligned_sized(void* ptr, size_t, size_t) {
+  __sanitizer_free(ptr);
+}
+
 __END_DECLS
 
 #define Malloc(function)  __sanitizer_ ## function
@@ -76,6 +84,9 @@ __END_DECLS
 
 const MallocDispatch* NativeAllocatorDispatch();
 
+// Handles android_mallopt(M_GET_SIZE_CLASS_STATS).
+bool GetSizeClassStats(void* arg, size_t arg_size);
+
 static inline const MallocDispatch* GetDispatchTable() {
   return atomic_load_explicit(&__libc_globals->current_dispatch_table, memory_order_acquire);
 }
@@ -84,6 +95,50 @@ static inline const MallocDispatch* GetDefaultDispatchTable() {
   return atomic_load_explicit(&__libc_globals->default_dispatch_table, memory_order_acquire);
 }
 
+// The sized frees and the batch functions are optional in a dispatch table,
+// since a library loaded by malloc_common_dynamic.cpp might not provide them.
+static inline void DispatchFreeSized(const MallocDispatch* dispatch_table, void* mem,
+                                     size_t size) {
+  if (dispatch_table->free_sized != nullptr) {
+    dispatch_table->free_sized(mem, size);
+  } else {
+    dispatch_table->free(mem);
+  }
+}
+
+static inline void DispatchFreeAlignedSized(const MallocDispatch* dispatch_table, void* mem,
+                                            size_t alignment, size_t size) {
+  if (dispatch_table->free_aligned_sized != nullptr) {
+    dispatch_table->free_aligned_sized(mem, alignment, size);
+  } else {
+    dispatch_table->free(mem);
+  }
+}
+
+static inline size_t DispatchMallocBatch(const MallocDispatch* dispatch_table, size_t size,
+                                         void** ptrs, size_t count) {
+  if (dispatch_table->malloc_batch != nullptr) {
+    return dispatch_table->malloc_batch(size, ptrs, count);
+  }
+  for (size_t i = 0; i < count; i++) {
+    ptrs[i] = dispatch_table->malloc(size);
+    if (ptrs[i] == nullptr) {
+      return i;
+    }
+  }
+  return count;
+}
+
+static inline void DispatchFreeBatch(const MallocDispatch* dispatch_table, void** ptrs,
+                                     size_t count) {
+  if (dispatch_table->free_batch != nullptr) {
+    return dispatch_table->free_batch(ptrs, count);
+  }
+  for (size_t i = 0; i < count; i++) {
+    dispatch_table->free(ptrs[i]);
+  }
+}
+
 // =============================================================================
 // Log functions
 // =============================================================================
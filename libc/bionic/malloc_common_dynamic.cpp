@@ -136,6 +136,15 @@ static bool InitMallocFunction(void* malloc_impl_handler, FunctionType* func, co
   return true;
 }
 
+// Like InitMallocFunction, but a missing function is not an error.
+template<typename FunctionType>
+static void InitOptionalMallocFunction(void* malloc_impl_handler, FunctionType* func,
+                                       const char* prefix, const char* suffix) {
+  char symbol[128];
+  snprintf(symbol, sizeof(symbol), "%s_%s", prefix, suffix);
+  *func = reinterpret_cast<FunctionType>(dlsym(malloc_impl_handler, symbol));
+}
+
 static bool InitMallocFunctions(void* impl_handler, MallocDispatch* table, const char* prefix) {
   if (!InitMallocFunction<MallocFree>(impl_handler, &table->free, prefix, "free")) {
     return false;
@@ -186,6 +195,16 @@ static bool InitMallocFunctions(void* impl_handler, MallocDispatch* table, const
                                               "malloc_enable")) {
     return false;
   }
+  // Older libraries (and heapprofd) don't have the sized frees or the batch
+  // functions, the callers fall back to malloc and free when they are null.
+  InitOptionalMallocFunction<MallocFreeSized>(impl_handler, &table->free_sized, prefix,
+                                              "free_sized");
+  InitOptionalMallocFunction<MallocFreeAlignedSized>(impl_handler, &table->free_aligned_sized,
+                                                     prefix, "free_aligned_sized");
+  InitOptionalMallocFunction<MallocMallocBatch>(impl_handler, &table->malloc_batch, prefix,
+                                                "malloc_batch");
+  InitOptionalMallocFunction<MallocFreeBatch>(impl_handler, &table->free_batch, prefix,
+                                              "free_batch");
 #if defined(HAVE_DEPRECATED_MALLOC_FUNCS)
   if (!InitMallocFunction<MallocPvalloc>(impl_handler, &table->pvalloc, prefix, "pvalloc")) {
     return false;
@@ -543,6 +562,9 @@ extern "C" bool android_mallopt(int opcode, void* arg, size_t arg_size) {
     *reinterpret_cast<bool*>(arg) = atomic_load(&__libc_globals->memtag_stack);
     return true;
   }
+  if (opcode == M_GET_SIZE_CLASS_STATS) {
+    return GetSizeClassStats(arg, arg_size);
+  }
   // Try heapprofd's mallopt, as it handles options not covered here.
   return HeapprofdMallopt(opcode, arg, arg_size);
 }
@@ -31,6 +31,7 @@
 #include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/param.h>
 
 #include <private/bionic_malloc_dispatch.h>
 
@@ -42,10 +43,13 @@
 #include "malloc_common_dynamic.h"
 #include "malloc_heapprofd.h"
 #include "malloc_limit.h"
+#include "pthread_internal.h"
 
 __BEGIN_DECLS
 static void* LimitCalloc(size_t n_elements, size_t elem_size);
 static void LimitFree(void* mem);
+static void LimitFreeSized(void* mem, size_t size);
+static void LimitFreeAlignedSized(void* mem, size_t alignment, size_t size);
 static void* LimitMalloc(size_t bytes);
 static void* LimitMemalign(size_t alignment, size_t bytes);
 static int LimitPosixMemalign(void** memptr, size_t alignment, size_t size);
@@ -88,17 +92,66 @@ static constexpr MallocDispatch __limit_dispatch
     LimitMallopt,
     LimitAlignedAlloc,
     LimitMallocInfo,
+    LimitFreeSized,
+    LimitFreeAlignedSized,
+    // Each allocation has to be checked against the limit, so let the batch
+    // functions fall back to LimitMalloc and LimitFree.
+    nullptr,
+    nullptr,
   };
 
-static _Atomic uint64_t gAllocated;
+// Usage is counted in kLimitShards cache-line-sized shards, picked by thread
+// id, so that threads allocating at the same time don't all hit one cache
+// line. A shard's count is folded into gAllocated whenever its magnitude
+// reaches kLimitShardBatch, so gAllocated is never off by more than
+// kLimitShards * kLimitShardBatch bytes in total, however many threads there
+// are. The limit check only adds up the shards when gAllocated is within that
+// margin of the limit.
+static constexpr size_t kLimitShards = 16;
+static constexpr int64_t kLimitShardBatch = 64 * 1024;
+static constexpr uint64_t kLimitMaxError = kLimitShards * kLimitShardBatch;
+
+struct alignas(64) LimitShard {
+  _Atomic int64_t pending;
+};
+
+static LimitShard gShards[kLimitShards];
+// This can be briefly negative when memory is freed on a different shard than
+// the one it was counted on.
+static _Atomic int64_t gAllocated;
 static uint64_t gAllocLimit;
 
+static inline void AddAllocated(int64_t bytes) {
+  LimitShard& shard = gShards[static_cast<uint32_t>(__get_thread()->tid) % kLimitShards];
+  int64_t pending =
+      atomic_fetch_add_explicit(&shard.pending, bytes, memory_order_relaxed) + bytes;
+  if (__predict_false(pending >= kLimitShardBatch || pending <= -kLimitShardBatch)) {
+    atomic_fetch_add_explicit(&gAllocated,
+                              atomic_exchange_explicit(&shard.pending, 0, memory_order_relaxed),
+                              memory_order_relaxed);
+  }
+}
+
+static int64_t ExactAllocated() {
+  int64_t total = atomic_load_explicit(&gAllocated, memory_order_relaxed);
+  for (auto& shard : gShards) {
+    total += atomic_load_explicit(&shard.pending, memory_order_relaxed);
+  }
+  return total;
+}
+
 static inline bool CheckLimit(size_t bytes) {
+  int64_t allocated = atomic_load_explicit(&gAllocated, memory_order_relaxed);
   uint64_t total;
-  if (__predict_false(__builtin_add_overflow(
-                          atomic_load_explicit(&gAllocated, memory_order_relaxed), bytes, &total) ||
-                      total > gAllocLimit)) {
-    return false;
+  if (__predict_false(__builtin_add_overflow(static_cast<uint64_t>(MAX(allocated, 0)), bytes,
+                                             &total) ||
+                      total > gAllocLimit - MIN(gAllocLimit, kLimitMaxError))) {
+    // Close enough to the limit that the unfolded shards matter.
+    allocated = ExactAllocated();
+    if (__builtin_add_overflow(static_cast<uint64_t>(MAX(allocated, 0)), bytes, &total) ||
+        total > gAllocLimit) {
+      return false;
+    }
   }
   return true;
 }
@@ -107,7 +160,7 @@ static inline void* IncrementLimit(void* mem) {
   if (__predict_false(mem == nullptr)) {
     return nullptr;
   }
-  atomic_fetch_add(&gAllocated, LimitUsableSize(mem));
+  AddAllocated(LimitUsableSize(mem));
   return mem;
 }
 
@@ -126,7 +179,7 @@ void* LimitCalloc(size_t n_elements, size_t elem_size) {
 }
 
 void LimitFree(void* mem) {
-  atomic_fetch_sub(&gAllocated, LimitUsableSize(mem));
+  AddAllocated(-static_cast<int64_t>(LimitUsableSize(mem)));
   auto dispatch_table = GetDefaultDispatchTable();
   if (__predict_false(dispatch_table != nullptr)) {
     return dispatch_table->free(mem);
@@ -134,6 +187,26 @@ void LimitFree(void* mem) {
   return Malloc(free)(mem);
 }
 
+// The usable size is still needed to keep the count in step with
+// IncrementLimit, so only the allocator benefits from the size.
+void LimitFreeSized(void* mem, size_t size) {
+  AddAllocated(-static_cast<int64_t>(LimitUsableSize(mem)));
+  auto dispatch_table = GetDefaultDispatchTable();
+  if (__predict_false(dispatch_table != nullptr)) {
+    return DispatchFreeSized(dispatch_table, mem, size);
+  }
+  return Malloc(free_sized)(mem, size);
+}
+
+void LimitFreeAlignedSized(void* mem, size_t alignment, size_t size) {
+  AddAllocated(-static_cast<int64_t>(LimitUsableSize(mem)));
+  auto dispatch_table = GetDefaultDispatchTable();
+  if (__predict_false(dispatch_table != nullptr)) {
+    return DispatchFreeAlignedSized(dispatch_table, mem, alignment, size);
+  }
+  return Malloc(free_aligned_sized)(mem, alignment, size);
+}
+
 void* LimitMalloc(size_t bytes) {
   if (!CheckLimit(bytes)) {
     warning_log("malloc_limit: malloc(%zu) exceeds limit %" PRId64, bytes, gAllocLimit);
@@ -213,17 +286,12 @@ static void* LimitRealloc(void* old_mem, size_t bytes) {
 
   if (__predict_false(new_ptr == nullptr)) {
     // This acts as if the pointer was freed.
-    atomic_fetch_sub(&gAllocated, old_usable_size);
+    AddAllocated(-static_cast<int64_t>(old_usable_size));
     return nullptr;
   }
 
   size_t new_usable_size = LimitUsableSize(new_ptr);
-  // Assumes that most allocations increase in size, rather than shrink.
-  if (__predict_false(old_usable_size > new_usable_size)) {
-    atomic_fetch_sub(&gAllocated, old_usable_size - new_usable_size);
-  } else {
-    atomic_fetch_add(&gAllocated, new_usable_size - old_usable_size);
-  }
+  AddAllocated(static_cast<int64_t>(new_usable_size) - static_cast<int64_t>(old_usable_size));
   return new_ptr;
 }
 
@@ -47,6 +47,14 @@ void  operator delete[](void* ptr) throw() {
     free(ptr);
 }
 
+void  operator delete(void* ptr, std::size_t size) throw() {
+    free_sized(ptr, size);
+}
+
+void  operator delete[](void* ptr, std::size_t size) throw() {
+    free_sized(ptr, size);
+}
+
 void* operator new(std::size_t size, const std::nothrow_t&) {
     return malloc(size);
 }
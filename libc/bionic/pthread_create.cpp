@@ -50,6 +50,7 @@
 #include "private/bionic_ssp.h"
 #include "private/bionic_systrace.h"
 #include "private/bionic_tls.h"
+#include "private/thread_private.h"
 
 // x86 uses segment descriptors rather than a direct pointer to TLS.
 #if defined(__i386__)
@@ -66,6 +67,7 @@ void __init_tcb_stack_guard(bionic_tcb* tcb) {
 void __init_bionic_tls_ptrs(bionic_tcb* tcb, bionic_tls* tls) {
   tcb->thread()->bionic_tls = tls;
   tcb->tls_slot(TLS_SLOT_BIONIC_TLS) = tls;
+  tls->rseq_area.cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
 }
 
 // Allocate a temporary bionic_tls that the dynamic linker's main thread can
@@ -367,6 +369,7 @@ static int __pthread_start(void* arg) {
 
   __set_stack_and_tls_vma_name(false);
   __init_additional_stacks(thread);
+  __rseq_register_current_thread();
   __rt_sigprocmask(SIG_SETMASK, &thread->start_mask, nullptr, sizeof(thread->start_mask));
 #ifdef __aarch64__
   // Chrome's sandbox prevents this prctl, so only reset IA if the target SDK level is high enough.
@@ -394,6 +397,17 @@ static void* __do_nothing(void*) {
 
 pthread_rwlock_t g_thread_creation_lock = PTHREAD_RWLOCK_INITIALIZER;
 
+// Set by clone(), which pthread_create() uses to start the thread, so raw
+// clone(CLONE_VM) callers are covered too. It's only written while the
+// process is still single-threaded, and thread creation orders the write
+// before anything the new thread does, so it doesn't need to be atomic.
+#if defined(__ANDROID_NATIVE_BRIDGE__)
+// The native bridge can replace both functions, so assume the worst.
+bool __libc_multithreaded = true;
+#else
+bool __libc_multithreaded = false;
+#endif
+
 __BIONIC_WEAK_FOR_NATIVE_BRIDGE
 int pthread_create(pthread_t* thread_out, pthread_attr_t const* attr,
                    void* (*start_routine)(void*), void* arg) {
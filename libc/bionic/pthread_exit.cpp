@@ -117,6 +117,10 @@ void pthread_exit(void* return_value) {
     __rt_sigprocmask(SIG_BLOCK, &set, nullptr, sizeof(sigset64_t));
   }
 
+  // The kernel writes to the rseq area whenever the thread is rescheduled, so
+  // stop it before the area (in static TLS) can be unmapped.
+  __rseq_unregister_current_thread();
+
 #if defined(__aarch64__) || defined(__riscv)
   // Free the shadow call stack and guard pages.
   munmap(thread->shadow_call_stack_guard_region, SCS_GUARD_REGION_SIZE);
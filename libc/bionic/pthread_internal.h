@@ -38,6 +38,7 @@
 #define __hwasan_thread_exit()
 #endif
 
+#include "private/bionic_allocator.h"
 #include "private/bionic_elf_tls.h"
 #include "private/bionic_lock.h"
 #include "private/bionic_tls.h"
@@ -165,6 +166,11 @@ class pthread_internal_t {
 
   thread_local_dtor* thread_local_dtors;
 
+  // Free blocks this thread holds on to for dynamic TLS allocations, so that
+  // threads don't serialize on the shared TLS allocator. Only used with signals
+  // blocked, and flushed by __free_dynamic_tls.
+  BionicAllocatorCache tls_allocator_cache;
+
   /*
    * The dynamic linker implements dlerror(3), which makes it hard for us to implement this
    * per-thread buffer by simply using malloc(3) and free(3).
@@ -200,6 +206,10 @@ __LIBC_HIDDEN__ void __init_tcb(bionic_tcb* tcb, pthread_internal_t* thread);
 __LIBC_HIDDEN__ void __init_tcb_stack_guard(bionic_tcb* tcb);
 __LIBC_HIDDEN__ void __init_tcb_dtv(bionic_tcb* tcb);
 __LIBC_HIDDEN__ void __init_bionic_tls_ptrs(bionic_tcb* tcb, bionic_tls* tls);
+__LIBC_HIDDEN__ void __rseq_register_current_thread();
+__LIBC_HIDDEN__ void __rseq_unregister_current_thread();
+__LIBC_HIDDEN__ void __rseq_set_target_sdk_version(int target);
+__LIBC_HIDDEN__ void __libc_init_rseq();
 __LIBC_HIDDEN__ bionic_tls* __allocate_temp_bionic_tls();
 __LIBC_HIDDEN__ void __free_temp_bionic_tls(bionic_tls* tls);
 __LIBC_HIDDEN__ void __init_additional_stacks(pthread_internal_t*);
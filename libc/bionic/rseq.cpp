@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <android/api-level.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bits/rseq.h>
+#include <linux/rseq.h>
+
+#include "private/ErrnoRestorer.h"
+#include "private/bionic_tls.h"
+#include "pthread_internal.h"
+
+extern "C" int __rseq(struct rseq*, uint32_t, int, uint32_t);
+
+// <sys/rseq.h> declares these const, but they're only known once the main
+// thread's static TLS is laid out.
+ptrdiff_t __rseq_offset;
+unsigned int __rseq_size;
+unsigned int __rseq_flags;
+
+// The part of struct rseq the kernel fills in (cpu_id_start through flags),
+// which is what glibc reports as __rseq_size.
+static constexpr unsigned int kRseqFeatureSize = 20;
+
+// Chrome's sandbox (and others like it) kills the process for system calls it
+// doesn't know, and apps that register their own rseq area get EBUSY if libc
+// already has, so only register for apps targeting an API level that has
+// <sys/rseq.h>. As with PAC in __pthread_start, this is checked as each
+// thread starts.
+static constexpr int kRseqMinTargetSdkVersion = __ANDROID_API_V__;
+
+// Like glibc's glibc.pthread.rseq=0 tunable, LIBC_RSEQ=0 in the environment
+// stops libc registering rseq areas at all. Only read at startup.
+static bool g_rseq_disabled;
+
+static inline bool rseq_enabled() {
+  return !g_rseq_disabled &&
+         android_get_application_target_sdk_version() >= kRseqMinTargetSdkVersion;
+}
+
+static inline bool rseq_registered(const struct rseq* area) {
+  return static_cast<int32_t>(area->cpu_id) >= 0;
+}
+
+void __rseq_register_current_thread() {
+  if (!rseq_enabled()) return;
+
+  ErrnoRestorer errno_restorer;
+  struct rseq* area = &__get_bionic_tls().rseq_area;
+  if (__rseq(area, sizeof(*area), 0, RSEQ_SIG) != 0) {
+    // Most likely a kernel without rseq (before 4.18), or a seccomp policy
+    // that doesn't allow it. sched_getcpu() falls back to the system call.
+    area->cpu_id = RSEQ_CPU_ID_REGISTRATION_FAILED;
+  }
+}
+
+void __rseq_unregister_current_thread() {
+  struct rseq* area = &__get_bionic_tls().rseq_area;
+  if (!rseq_registered(area)) return;
+
+  ErrnoRestorer errno_restorer;
+  __rseq(area, sizeof(*area), RSEQ_FLAG_UNREGISTER, RSEQ_SIG);
+  area->cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
+}
+
+void __rseq_set_target_sdk_version(int target) {
+  if (target >= kRseqMinTargetSdkVersion) return;
+
+  // An app forked from the zygote inherits the zygote's registration for
+  // this (its only) thread. Drop it so the app can register its own, and so
+  // that __rseq_size tells the truth about threads started from now on.
+  __rseq_unregister_current_thread();
+  __rseq_size = 0;
+}
+
+void __libc_init_rseq() {
+  const char* env = getenv("LIBC_RSEQ");
+  g_rseq_disabled = (env != nullptr && strcmp(env, "0") == 0);
+
+  // The main thread's static TLS is in its final place by now (for dynamic
+  // executables the linker moved it before running any constructors), and
+  // the environment is available, so this is the first point we can register.
+  __rseq_register_current_thread();
+
+  struct rseq* area = &__get_bionic_tls().rseq_area;
+  __rseq_offset = reinterpret_cast<char*>(area) - reinterpret_cast<char*>(__get_tls());
+  __rseq_size = rseq_registered(area) ? kRseqFeatureSize : 0;
+  __rseq_flags = 0;
+}
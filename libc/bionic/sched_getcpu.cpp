@@ -28,10 +28,23 @@
 
 #define _GNU_SOURCE 1
 #include <sched.h>
+#include <stdint.h>
+
+#include "private/bionic_tls.h"
+#include "pthread_internal.h"
 
 extern "C" int __getcpu(unsigned*, unsigned*, void*);
 
 int sched_getcpu() {
+  // If this thread's rseq area is registered, the kernel keeps cpu_id up to
+  // date, and we can skip the system call. (A clone(CLONE_VM) child without
+  // CLONE_SETTLS sees its parent's area instead; see <sched.h>.)
+  int32_t rseq_cpu = static_cast<int32_t>(
+      __atomic_load_n(&__get_bionic_tls().rseq_area.cpu_id, __ATOMIC_RELAXED));
+  if (__predict_true(rseq_cpu >= 0)) {
+    return rseq_cpu;
+  }
+
   unsigned cpu;
   int rc = __getcpu(&cpu, nullptr, nullptr);
   if (rc == -1) {
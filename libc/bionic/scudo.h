@@ -28,10 +28,12 @@
 
 #pragma once
 
+#include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <malloc.h>
 
+#include <platform/bionic/malloc.h>
 #include <private/bionic_config.h>
 
 __BEGIN_DECLS
@@ -56,6 +58,22 @@ int scudo_malloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*),
 void scudo_malloc_disable();
 void scudo_malloc_enable();
 
+// Scudo's C interface doesn't take a size on free, so the sized frees are
+// plain frees.
+static inline void scudo_free_sized(void* ptr, size_t) {
+  scudo_free(ptr);
+}
+static inline void scudo_free_aligned_sized(void* ptr, size_t, size_t) {
+  scudo_free(ptr);
+}
+
+// Scudo keeps per size class counters, but has no interface to read them
+// other than printing them as text.
+static inline bool scudo_size_class_stats(android_mallopt_size_class_stats_t*) {
+  errno = ENOTSUP;
+  return false;
+}
+
 void* scudo_svelte_aligned_alloc(size_t, size_t);
 void* scudo_svelte_calloc(size_t, size_t);
 void scudo_svelte_free(void*);
@@ -76,4 +94,16 @@ int scudo_svelte_malloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, v
 void scudo_svelte_malloc_disable();
 void scudo_svelte_malloc_enable();
 
+static inline void scudo_svelte_free_sized(void* ptr, size_t) {
+  scudo_svelte_free(ptr);
+}
+static inline void scudo_svelte_free_aligned_sized(void* ptr, size_t, size_t) {
+  scudo_svelte_free(ptr);
+}
+
+static inline bool scudo_svelte_size_class_stats(android_mallopt_size_class_stats_t*) {
+  errno = ENOTSUP;
+  return false;
+}
+
 __END_DECLS
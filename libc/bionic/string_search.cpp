@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// memmem, strstr and strcasestr for architectures with a SIMD "find pair"
+// kernel (see the arch-*/string/*find-pair* files).
+//
+// The kernel scans for positions where the needle's first and last bytes
+// both match, which rejects almost every position in practice, and we check
+// each candidate in full. If too many candidates turn out to be false
+// positives (highly repetitive input), we switch to the Two-Way algorithm,
+// which is linear in the worst case.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Returns the first position p in [h, h + count) where h[p] is either of the
+// low two bytes of `chars` and h[p + gap] is either of the high two bytes, or
+// nullptr. Reads no further than h + count + gap.
+typedef const unsigned char* find_pair_func(const unsigned char* h, size_t count, uint32_t chars,
+                                            size_t gap);
+
+namespace {
+
+// After this many false positives, switch to Two-Way if we're averaging
+// less than kBytesPerFalsePositive bytes of progress for each one.
+constexpr size_t kMinFalsePositives = 64;
+constexpr size_t kBytesPerFalsePositive = 16;
+
+// How much more of a NUL-terminated haystack to find the end of at a time.
+constexpr size_t kStringChunkSize = 4096;
+
+struct ExactMatch {
+  static unsigned char Fold(unsigned char c) { return c; }
+  static uint32_t Pair(unsigned char first, unsigned char last) {
+    return first | (first << 8) | (last << 16) | (static_cast<uint32_t>(last) << 24);
+  }
+};
+
+struct CaseInsensitiveMatch {
+  static unsigned char Fold(unsigned char c) { return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c; }
+  static unsigned char Other(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return c - ('a' - 'A');
+    return c;
+  }
+  static uint32_t Pair(unsigned char first, unsigned char last) {
+    first = Fold(first);
+    last = Fold(last);
+    return first | (Other(first) << 8) | (last << 16) | (static_cast<uint32_t>(Other(last)) << 24);
+  }
+};
+
+// A haystack whose length is known up front.
+class BoundedHaystack {
+ public:
+  explicit BoundedHaystack(const unsigned char* end) : end_(end) {}
+
+  // Returns how many bytes from h are available, which is at least `want`
+  // unless the haystack ends sooner.
+  size_t Available(const unsigned char* h, size_t) { return end_ - h; }
+
+ private:
+  const unsigned char* end_;
+};
+
+// A NUL-terminated haystack, whose end we find lazily so we don't scan all
+// of a long string when the needle is near the start.
+class StringHaystack {
+ public:
+  explicit StringHaystack(const unsigned char* h) : end_(h), found_nul_(false) {}
+
+  size_t Available(const unsigned char* h, size_t want) {
+    while (static_cast<size_t>(end_ - h) < want && !found_nul_) {
+      size_t grow = want - (end_ - h);
+      if (grow < kStringChunkSize) grow = kStringChunkSize;
+      size_t n = strnlen(reinterpret_cast<const char*>(end_), grow);
+      end_ += n;
+      found_nul_ = (n < grow);
+    }
+    return end_ - h;
+  }
+
+ private:
+  const unsigned char* end_;
+  bool found_nul_;
+};
+
+template <typename Match>
+bool Equal(const unsigned char* a, const unsigned char* b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    if (Match::Fold(a[i]) != Match::Fold(b[i])) return false;
+  }
+  return true;
+}
+
+template <>
+bool Equal<ExactMatch>(const unsigned char* a, const unsigned char* b, size_t n) {
+  return memcmp(a, b, n) == 0;
+}
+
+// Two-Way string matching (Crochemore and Perrin), as in the OpenBSD/musl
+// memmem, generalized over case folding and the kind of haystack.
+template <typename Match, typename Haystack>
+const unsigned char* TwoWay(const unsigned char* h, Haystack& haystack, const unsigned char* n,
+                            size_t l) {
+  // The shift table uses 32-bit entries to keep the frame small, so needles
+  // too long for that go without it (every byte is treated as a possible
+  // match, which is slower but still correct).
+  const bool use_shift = (l < UINT32_MAX);
+  size_t byteset[32 / sizeof(size_t)] = {};
+  uint32_t shift[256];
+  if (use_shift) {
+    for (size_t i = 0; i < l; ++i) {
+      unsigned char c = Match::Fold(n[i]);
+      byteset[c / (8 * sizeof(size_t))] |= static_cast<size_t>(1) << (c % (8 * sizeof(size_t)));
+      shift[c] = i + 1;
+    }
+  }
+
+  // Compute the maximal suffix.
+  size_t ip = -1, jp = 0, k = 1, p = 1;
+  while (jp + k < l) {
+    unsigned char a = Match::Fold(n[ip + k]), b = Match::Fold(n[jp + k]);
+    if (a == b) {
+      if (k == p) {
+        jp += p;
+        k = 1;
+      } else {
+        k++;
+      }
+    } else if (a > b) {
+      jp += k;
+      k = 1;
+      p = jp - ip;
+    } else {
+      ip = jp++;
+      k = p = 1;
+    }
+  }
+  size_t ms = ip;
+  size_t p0 = p;
+
+  // And with the opposite comparison.
+  ip = -1;
+  jp = 0;
+  k = p = 1;
+  while (jp + k < l) {
+    unsigned char a = Match::Fold(n[ip + k]), b = Match::Fold(n[jp + k]);
+    if (a == b) {
+      if (k == p) {
+        jp += p;
+        k = 1;
+      } else {
+        k++;
+      }
+    } else if (a < b) {
+      jp += k;
+      k = 1;
+      p = jp - ip;
+    } else {
+      ip = jp++;
+      k = p = 1;
+    }
+  }
+  if (ip + 1 > ms + 1) {
+    ms = ip;
+  } else {
+    p = p0;
+  }
+
+  // Periodic needle?
+  size_t mem0;
+  if (!Equal<Match>(n, n + p, ms + 1)) {
+    mem0 = 0;
+    p = ((ms > l - ms - 1) ? ms : l - ms - 1) + 1;
+  } else {
+    mem0 = l - p;
+  }
+  size_t mem = 0;
+
+  while (true) {
+    if (haystack.Available(h, l) < l) return nullptr;
+
+    // Check the last byte first, and skip ahead by the shift on a mismatch.
+    if (use_shift) {
+      unsigned char c = Match::Fold(h[l - 1]);
+      if (byteset[c / (8 * sizeof(size_t))] & (static_cast<size_t>(1) << (c % (8 * sizeof(size_t))))) {
+        k = l - shift[c];
+        if (k) {
+          if (k < mem) k = mem;
+          h += k;
+          mem = 0;
+          continue;
+        }
+      } else {
+        h += l;
+        mem = 0;
+        continue;
+      }
+    }
+
+    // Compare the right half.
+    for (k = (ms + 1 > mem) ? ms + 1 : mem; k < l && Match::Fold(n[k]) == Match::Fold(h[k]); k++) {
+    }
+    if (k < l) {
+      h += k - ms;
+      mem = 0;
+      continue;
+    }
+    // Compare the left half.
+    for (k = ms + 1; k > mem && Match::Fold(n[k - 1]) == Match::Fold(h[k - 1]); k--) {
+    }
+    if (k <= mem) return h;
+    h += p;
+    mem = mem0;
+  }
+}
+
+template <find_pair_func* FindPair, typename Match, typename Haystack>
+const unsigned char* Search(const unsigned char* h, Haystack& haystack, const unsigned char* n,
+                            size_t l) {
+  const uint32_t chars = Match::Pair(n[0], n[l - 1]);
+  const unsigned char* start = h;
+  size_t false_positives = 0;
+  while (true) {
+    size_t available = haystack.Available(h, l + kStringChunkSize);
+    if (available < l) return nullptr;
+
+    size_t count = available - l + 1;
+    const unsigned char* candidate = FindPair(h, count, chars, l - 1);
+    if (candidate == nullptr) {
+      h += count;
+      continue;
+    }
+    if (l <= 2 || Equal<Match>(candidate + 1, n + 1, l - 2)) return candidate;
+
+    h = candidate + 1;
+    if (++false_positives > kMinFalsePositives &&
+        false_positives * kBytesPerFalsePositive > static_cast<size_t>(h - start)) {
+      return TwoWay<Match>(h, haystack, n, l);
+    }
+  }
+}
+
+template <find_pair_func* FindPair>
+void* MemMem(const void* haystack, size_t haystack_size, const void* needle, size_t needle_size) {
+  const unsigned char* h = static_cast<const unsigned char*>(haystack);
+  const unsigned char* n = static_cast<const unsigned char*>(needle);
+  if (needle_size == 0) return const_cast<unsigned char*>(h);
+  if (haystack_size < needle_size) return nullptr;
+  if (needle_size == 1) return const_cast<void*>(memchr(h, *n, haystack_size));
+
+  BoundedHaystack bounded(h + haystack_size);
+  return const_cast<unsigned char*>(Search<FindPair, ExactMatch>(h, bounded, n, needle_size));
+}
+
+template <find_pair_func* FindPair>
+char* StrStr(const char* haystack, const char* needle) {
+  if (needle[0] == '\0') return const_cast<char*>(haystack);
+  if (needle[1] == '\0') return const_cast<char*>(strchr(haystack, needle[0]));
+
+  const unsigned char* h = reinterpret_cast<const unsigned char*>(haystack);
+  const unsigned char* n = reinterpret_cast<const unsigned char*>(needle);
+  StringHaystack string(h);
+  return const_cast<char*>(
+      reinterpret_cast<const char*>(Search<FindPair, ExactMatch>(h, string, n, strlen(needle))));
+}
+
+template <find_pair_func* FindPair>
+char* StrCaseStr(const char* haystack, const char* needle) {
+  if (needle[0] == '\0') return const_cast<char*>(haystack);
+
+  const unsigned char* h = reinterpret_cast<const unsigned char*>(haystack);
+  const unsigned char* n = reinterpret_cast<const unsigned char*>(needle);
+  StringHaystack string(h);
+  return const_cast<char*>(reinterpret_cast<const char*>(
+      Search<FindPair, CaseInsensitiveMatch>(h, string, n, strlen(needle))));
+}
+
+}  // namespace
+
+#define DEFINE_STRING_SEARCH_FUNCTIONS(suffix, find_pair)                                       \
+  extern "C" __LIBC_HIDDEN__ find_pair_func find_pair;                                          \
+  extern "C" void* memmem##suffix(const void* h, size_t h_size, const void* n, size_t n_size) { \
+    return MemMem<find_pair>(h, h_size, n, n_size);                                             \
+  }                                                                                             \
+  extern "C" char* strstr##suffix(const char* h, const char* n) {                               \
+    return StrStr<find_pair>(h, n);                                                             \
+  }                                                                                             \
+  extern "C" char* strcasestr##suffix(const char* h, const char* n) {                           \
+    return StrCaseStr<find_pair>(h, n);                                                         \
+  }
+
+#if defined(__aarch64__)
+DEFINE_STRING_SEARCH_FUNCTIONS(_aarch64_simd, __find_pair_aarch64_simd)
+#elif defined(__x86_64__)
+DEFINE_STRING_SEARCH_FUNCTIONS(_sse2, __find_pair_sse2)
+DEFINE_STRING_SEARCH_FUNCTIONS(_avx2, __find_pair_avx2)
+#endif
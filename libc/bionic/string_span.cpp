@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// strspn, strcspn and strpbrk for architectures with a SIMD "span" kernel
+// (see the arch-*/string/*span* files).
+//
+// We build a 256-bit set of the bytes once per call, and the kernel then
+// classifies a whole vector of input at a time with table lookups rather
+// than rescanning the accept/reject string for every byte.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Returns the length of the initial run of `s` made up of bytes in `set`.
+// The set must not contain NUL.
+//
+// The set is stored as two 16-byte tables indexed by the low nibble of a
+// byte: byte b is in the set if bit ((b >> 4) & 7) of
+// set[(b >> 7) * 16 + (b & 0xf)] is set. This is the layout the kernels'
+// nibble lookups (PSHUFB or TBL) want.
+typedef size_t span_func(const char* s, const uint8_t* set);
+
+namespace {
+
+class ByteSet {
+ public:
+  ByteSet() : bits_{} {}
+
+  void Add(uint8_t b) { bits_[(b >> 7) * 16 + (b & 0xf)] |= 1 << ((b >> 4) & 7); }
+
+  void Invert() {
+    for (uint8_t& bits : bits_) bits = ~bits;
+  }
+
+  const uint8_t* data() const { return bits_; }
+
+ private:
+  alignas(16) uint8_t bits_[32];
+};
+
+template <span_func* Span>
+size_t StrSpn(const char* s, const char* accept) {
+  if (accept[0] == '\0') return 0;
+  if (accept[1] == '\0') {
+    const char* p = s;
+    while (*p == accept[0]) ++p;
+    return p - s;
+  }
+
+  ByteSet set;
+  for (const char* p = accept; *p != '\0'; ++p) set.Add(*p);
+  return Span(s, set.data());
+}
+
+template <span_func* Span>
+size_t StrCSpn(const char* s, const char* reject) {
+  if (reject[0] == '\0') return strlen(s);
+  if (reject[1] == '\0') return strchrnul(s, reject[0]) - s;
+
+  // The span of bytes *not* in the reject set, where the terminating NUL
+  // counts as rejected.
+  ByteSet set;
+  set.Add('\0');
+  for (const char* p = reject; *p != '\0'; ++p) set.Add(*p);
+  set.Invert();
+  return Span(s, set.data());
+}
+
+template <span_func* Span>
+char* StrPBrk(const char* s, const char* accept) {
+  s += StrCSpn<Span>(s, accept);
+  return (*s != '\0') ? const_cast<char*>(s) : nullptr;
+}
+
+}  // namespace
+
+#define DEFINE_STRING_SPAN_FUNCTIONS(suffix, span)                       \
+  extern "C" __LIBC_HIDDEN__ span_func span;                             \
+  extern "C" size_t strspn##suffix(const char* s, const char* accept) {  \
+    return StrSpn<span>(s, accept);                                      \
+  }                                                                      \
+  extern "C" size_t strcspn##suffix(const char* s, const char* reject) { \
+    return StrCSpn<span>(s, reject);                                     \
+  }                                                                      \
+  extern "C" char* strpbrk##suffix(const char* s, const char* accept) {  \
+    return StrPBrk<span>(s, accept);                                     \
+  }
+
+#if defined(__aarch64__)
+DEFINE_STRING_SPAN_FUNCTIONS(_aarch64_simd, __span_aarch64_simd)
+#elif defined(__x86_64__)
+DEFINE_STRING_SPAN_FUNCTIONS(_ssse3, __span_ssse3)
+DEFINE_STRING_SPAN_FUNCTIONS(_avx2, __span_avx2)
+#endif
@@ -44,6 +44,7 @@
 #endif
 
 #include "private/ErrnoRestorer.h"
+#include "private/ScopedSignalBlocker.h"
 #include "private/bionic_elf_tls.h"
 #include "private/bionic_globals.h"
 #include "private/bionic_tls.h"
@@ -63,9 +64,12 @@ void __libc_register_thread_exit_callback(thread_exit_cb_t cb) {
     return;
   };
 
+  // The TLS allocator is only used through per-thread caches, which mustn't be
+  // touched by a signal handler at the same time.
+  ScopedSignalBlocker ssb;
   BionicAllocator& allocator = __libc_shared_globals()->tls_allocator;
-  CallbackHolder* new_node =
-      reinterpret_cast<CallbackHolder*>(allocator.alloc(sizeof(CallbackHolder)));
+  CallbackHolder* new_node = reinterpret_cast<CallbackHolder*>(
+      allocator.alloc(sizeof(CallbackHolder), &__get_thread()->tls_allocator_cache));
   new_node->cb = cb;
   new_node->prev = modules.thread_exit_callback_tail_node;
   modules.thread_exit_callback_tail_node = new_node;
@@ -78,6 +78,25 @@ void* _Nullable reallocarray(void* _Nullable __ptr, size_t __item_count, size_t
  */
 void free(void* _Nullable __ptr);
 
+/**
+ * [free_sized(3)](https://www.open-std.org/jtc1/sc22/wg14/www/docs/n2699.htm)
+ * deallocates memory on the heap that was allocated by malloc(), calloc(), or
+ * realloc() with a size of `__byte_count`. The allocator can use the size to
+ * avoid looking it up.
+ *
+ * Available since API level 35.
+ */
+void free_sized(void* _Nullable __ptr, size_t __byte_count) __INTRODUCED_IN(35);
+
+/**
+ * [free_aligned_sized(3)](https://www.open-std.org/jtc1/sc22/wg14/www/docs/n2699.htm)
+ * deallocates memory on the heap that was allocated by aligned_alloc() with an
+ * alignment of `__alignment` and a size of `__byte_count`.
+ *
+ * Available since API level 35.
+ */
+void free_aligned_sized(void* _Nullable __ptr, size_t __alignment, size_t __byte_count) __INTRODUCED_IN(35);
+
 /**
  * [memalign(3)](http://man7.org/linux/man-pages/man3/memalign.3.html) allocates
  * memory on the heap with the required alignment.
@@ -169,6 +169,11 @@ int sched_rr_get_interval(pid_t __pid, struct timespec* _Nonnull __quantum);
  * [clone(2)](http://man7.org/linux/man-pages/man2/clone.2.html)
  * creates a new child process.
  *
+ * A child created with `CLONE_VM` but without `CLONE_SETTLS` shares the
+ * caller's thread-local storage, including the rseq area that sched_getcpu()
+ * reads, so sched_getcpu() in such a child may report the caller's CPU. Such
+ * a child should make the getcpu system call directly instead.
+ *
  * Returns the pid of the child to the caller on success and
  * returns -1 and sets `errno` on failure.
  */
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+/**
+ * @file sys/rseq.h
+ * @brief Restartable sequences.
+ *
+ * libc registers a `struct rseq` for every thread, so code that wants to use
+ * restartable sequences must use libc's rather than registering its own (the
+ * kernel only allows one per thread). As with glibc, the calling thread's area
+ * is at `__builtin_thread_pointer() + __rseq_offset`, and is only usable if
+ * `__rseq_size` is non-zero.
+ *
+ * libc only registers areas for apps with a target API level of 35 or later,
+ * and not at all if the environment variable `LIBC_RSEQ` is `0` at startup
+ * (like glibc's `glibc.pthread.rseq=0` tunable). In either case `__rseq_size`
+ * is 0, and code is free to register its own area.
+ */
+
+#include <sys/cdefs.h>
+#include <stddef.h>
+
+#include <bits/rseq.h>
+#include <linux/rseq.h>
+
+__BEGIN_DECLS
+
+/**
+ * The offset of the calling thread's `struct rseq` from the thread pointer.
+ *
+ * Available since API level 35.
+ */
+extern const ptrdiff_t __rseq_offset __INTRODUCED_IN(35);
+
+/**
+ * The size of the part of `struct rseq` the kernel keeps up to date, or 0 if
+ * libc didn't register an area (for example, because the kernel is too old,
+ * or because registration is turned off).
+ *
+ * Available since API level 35.
+ */
+extern const unsigned int __rseq_size __INTRODUCED_IN(35);
+
+/**
+ * The flags libc registered the area with.
+ *
+ * Available since API level 35.
+ */
+extern const unsigned int __rseq_flags __INTRODUCED_IN(35);
+
+__END_DECLS
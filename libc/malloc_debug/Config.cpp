@@ -130,6 +130,14 @@ const std::unordered_map<std::string, Config::OptionInfo> Config::kOptions = {
         "bt_dmp_on_ex",
         {0, &Config::SetBacktraceDumpOnExit},
     },
+    {
+        "backtrace_dump_binary",
+        {0, &Config::SetBacktraceDumpBinary},
+    },
+    {
+        "bt_dmp_bin",
+        {0, &Config::SetBacktraceDumpBinary},
+    },
     {
         "backtrace_dump_prefix",
         {0, &Config::SetBacktraceDumpPrefix},
@@ -146,6 +154,14 @@ const std::unordered_map<std::string, Config::OptionInfo> Config::kOptions = {
         "bt_full",
         {BACKTRACE_FULL, &Config::VerifyValueEmpty},
     },
+    {
+        "backtrace_fp",
+        {BACKTRACE_FP, &Config::VerifyValueEmpty},
+    },
+    {
+        "bt_fp",
+        {BACKTRACE_FP, &Config::VerifyValueEmpty},
+    },
 
     {
         "fill",
@@ -331,6 +347,14 @@ bool Config::SetBacktraceDumpOnExit(const std::string& option, const std::string
   return false;
 }
 
+bool Config::SetBacktraceDumpBinary(const std::string& option, const std::string& value) {
+  if (Config::VerifyValueEmpty(option, value)) {
+    backtrace_dump_binary_ = true;
+    return true;
+  }
+  return false;
+}
+
 bool Config::SetBacktraceDumpPrefix(const std::string&, const std::string& value) {
   if (value.empty()) {
     backtrace_dump_prefix_ = DEFAULT_BACKTRACE_DUMP_PREFIX;
@@ -462,6 +486,7 @@ bool Config::Init(const char* options_str) {
   backtrace_enable_on_signal_ = false;
   backtrace_enabled_ = false;
   backtrace_dump_on_exit_ = false;
+  backtrace_dump_binary_ = false;
   backtrace_dump_prefix_ = DEFAULT_BACKTRACE_DUMP_PREFIX;
   backtrace_min_size_bytes_ = 0;
   backtrace_max_size_bytes_ = SIZE_MAX;
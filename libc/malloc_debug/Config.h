@@ -48,6 +48,7 @@ constexpr uint64_t ABORT_ON_ERROR = 0x800;
 constexpr uint64_t VERBOSE = 0x1000;
 constexpr uint64_t CHECK_UNREACHABLE_ON_SIGNAL = 0x2000;
 constexpr uint64_t BACKTRACE_SPECIFIC_SIZES = 0x4000;
+constexpr uint64_t BACKTRACE_FP = 0x8000;
 
 // In order to guarantee posix compliance, set the minimum alignment
 // to 8 bytes for 32 bit systems and 16 bytes for 64 bit systems.
@@ -74,6 +75,7 @@ class Config {
   size_t backtrace_enabled() const { return backtrace_enabled_; }
   size_t backtrace_enable_on_signal() const { return backtrace_enable_on_signal_; }
   bool backtrace_dump_on_exit() const { return backtrace_dump_on_exit_; }
+  bool backtrace_dump_binary() const { return backtrace_dump_binary_; }
   const std::string& backtrace_dump_prefix() const { return backtrace_dump_prefix_; }
 
   size_t front_guard_bytes() const { return front_guard_bytes_; }
@@ -123,6 +125,7 @@ class Config {
   bool SetBacktrace(const std::string& option, const std::string& value);
   bool SetBacktraceEnableOnSignal(const std::string& option, const std::string& value);
   bool SetBacktraceDumpOnExit(const std::string& option, const std::string& value);
+  bool SetBacktraceDumpBinary(const std::string& option, const std::string& value);
   bool SetBacktraceDumpPrefix(const std::string& option, const std::string& value);
 
   bool SetBacktraceSize(const std::string& option, const std::string& value);
@@ -152,6 +155,7 @@ class Config {
   bool backtrace_enabled_ = false;
   size_t backtrace_frames_ = 0;
   bool backtrace_dump_on_exit_ = false;
+  bool backtrace_dump_binary_ = false;
   std::string backtrace_dump_prefix_;
   size_t backtrace_min_size_bytes_ = 0;
   size_t backtrace_max_size_bytes_ = 0;
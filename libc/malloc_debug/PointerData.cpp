@@ -43,6 +43,7 @@
 #include <utility>
 #include <vector>
 
+#include <android-base/file.h>
 #include <android-base/stringprintf.h>
 #include <android-base/thread_annotations.h>
 #include <platform/bionic/macros.h>
@@ -58,18 +59,10 @@
 std::atomic_uint8_t PointerData::backtrace_enabled_;
 std::atomic_bool PointerData::backtrace_dump_;
 
-std::mutex PointerData::pointer_mutex_;
-std::unordered_map<uintptr_t, PointerInfoType> PointerData::pointers_ GUARDED_BY(
-    PointerData::pointer_mutex_);
+PointerData::PointerShard PointerData::pointer_shards_[PointerData::kPointerShards];
 
-std::mutex PointerData::frame_mutex_;
-std::unordered_map<FrameKeyType, size_t> PointerData::key_to_index_ GUARDED_BY(
-    PointerData::frame_mutex_);
-std::unordered_map<size_t, FrameInfoType> PointerData::frames_ GUARDED_BY(PointerData::frame_mutex_);
-std::unordered_map<size_t, std::vector<unwindstack::FrameData>> PointerData::backtraces_info_
-    GUARDED_BY(PointerData::frame_mutex_);
+PointerData::FrameShard PointerData::frame_shards_[PointerData::kFrameShards];
 constexpr size_t kBacktraceEmptyIndex = 1;
-size_t PointerData::cur_hash_index_ GUARDED_BY(PointerData::frame_mutex_);
 
 std::mutex PointerData::free_pointer_mutex_;
 std::deque<FreePointerInfoType> PointerData::free_pointers_ GUARDED_BY(
@@ -90,13 +83,20 @@ static void EnableDump(int, siginfo_t*, void*) {
 PointerData::PointerData(DebugData* debug_data) : OptionData(debug_data) {}
 
 bool PointerData::Initialize(const Config& config) NO_THREAD_SAFETY_ANALYSIS {
-  pointers_.clear();
-  key_to_index_.clear();
-  frames_.clear();
-  free_pointers_.clear();
+  for (auto& shard : pointer_shards_) {
+    shard.pointers.clear();
+  }
   // A hash index of kBacktraceEmptyIndex indicates that we tried to get
-  // a backtrace, but there was nothing recorded.
-  cur_hash_index_ = kBacktraceEmptyIndex + 1;
+  // a backtrace, but there was nothing recorded. Every shard starts handing
+  // out indexes at kFrameShards or above, so that can never collide.
+  static_assert(kFrameShards > kBacktraceEmptyIndex);
+  for (auto& shard : frame_shards_) {
+    shard.key_to_index.clear();
+    shard.frames.clear();
+    shard.backtraces_info.clear();
+    shard.next_index = 1;
+  }
+  free_pointers_.clear();
 
   backtrace_enabled_ = config.backtrace_enabled();
   if (config.backtrace_enable_on_signal()) {
@@ -159,7 +159,11 @@ size_t PointerData::AddBacktrace(size_t num_frames, size_t size_bytes) {
     }
   } else {
     frames.resize(num_frames);
-    num_frames = backtrace_get(frames.data(), frames.size());
+    if (g_debug->config().options() & BACKTRACE_FP) {
+      num_frames = backtrace_get_fp(frames.data(), frames.size());
+    } else {
+      num_frames = backtrace_get(frames.data(), frames.size());
+    }
     if (num_frames == 0) {
       return kBacktraceEmptyIndex;
     }
@@ -167,21 +171,24 @@ size_t PointerData::AddBacktrace(size_t num_frames, size_t size_bytes) {
   }
 
   FrameKeyType key{.num_frames = frames.size(), .frames = frames.data()};
+  size_t key_hash = std::hash<FrameKeyType>()(key);
+  size_t shard_index = (key_hash ^ (key_hash >> 16)) % kFrameShards;
+  FrameShard& shard = frame_shards_[shard_index];
   size_t hash_index;
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-  auto entry = key_to_index_.find(key);
-  if (entry == key_to_index_.end()) {
-    hash_index = cur_hash_index_++;
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
+  auto entry = shard.key_to_index.find(key);
+  if (entry == shard.key_to_index.end()) {
+    hash_index = shard.next_index++ * kFrameShards + shard_index;
     key.frames = frames.data();
-    key_to_index_.emplace(key, hash_index);
+    shard.key_to_index.emplace(key, hash_index);
 
-    frames_.emplace(hash_index, FrameInfoType{.references = 1, .frames = std::move(frames)});
+    shard.frames.emplace(hash_index, FrameInfoType{.references = 1, .frames = std::move(frames)});
     if (g_debug->config().options() & BACKTRACE_FULL) {
-      backtraces_info_.emplace(hash_index, std::move(frames_info));
+      shard.backtraces_info.emplace(hash_index, std::move(frames_info));
     }
   } else {
     hash_index = entry->second;
-    FrameInfoType* frame_info = &frames_[hash_index];
+    FrameInfoType* frame_info = &shard.frames[hash_index];
     frame_info->references++;
   }
   return hash_index;
@@ -192,19 +199,20 @@ void PointerData::RemoveBacktrace(size_t hash_index) {
     return;
   }
 
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-  auto frame_entry = frames_.find(hash_index);
-  if (frame_entry == frames_.end()) {
+  FrameShard& shard = GetFrameShard(hash_index);
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
+  auto frame_entry = shard.frames.find(hash_index);
+  if (frame_entry == shard.frames.end()) {
     error_log("hash_index %zu does not have matching frame data.", hash_index);
     return;
   }
   FrameInfoType* frame_info = &frame_entry->second;
   if (--frame_info->references == 0) {
     FrameKeyType key{.num_frames = frame_info->frames.size(), .frames = frame_info->frames.data()};
-    key_to_index_.erase(key);
-    frames_.erase(hash_index);
+    shard.key_to_index.erase(key);
+    shard.frames.erase(hash_index);
     if (g_debug->config().options() & BACKTRACE_FULL) {
-      backtraces_info_.erase(hash_index);
+      shard.backtraces_info.erase(hash_index);
     }
   }
 }
@@ -215,25 +223,27 @@ void PointerData::Add(const void* ptr, size_t pointer_size) {
     hash_index = AddBacktrace(g_debug->config().backtrace_frames(), pointer_size);
   }
 
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
   uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-  pointers_[mangled_ptr] =
+  PointerShard& shard = GetPointerShard(mangled_ptr);
+  std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+  shard.pointers[mangled_ptr] =
       PointerInfoType{PointerInfoType::GetEncodedSize(pointer_size), hash_index};
 }
 
 void PointerData::Remove(const void* ptr) {
   size_t hash_index;
   {
-    std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
     uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-    auto entry = pointers_.find(mangled_ptr);
-    if (entry == pointers_.end()) {
+    PointerShard& shard = GetPointerShard(mangled_ptr);
+    std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+    auto entry = shard.pointers.find(mangled_ptr);
+    if (entry == shard.pointers.end()) {
       // Attempt to remove unknown pointer.
       error_log("No tracked pointer found for 0x%" PRIxPTR, DemanglePointer(mangled_ptr));
       return;
     }
     hash_index = entry->second.hash_index;
-    pointers_.erase(mangled_ptr);
+    shard.pointers.erase(entry);
   }
 
   RemoveBacktrace(hash_index);
@@ -242,10 +252,11 @@ void PointerData::Remove(const void* ptr) {
 size_t PointerData::GetFrames(const void* ptr, uintptr_t* frames, size_t max_frames) {
   size_t hash_index;
   {
-    std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
     uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-    auto entry = pointers_.find(mangled_ptr);
-    if (entry == pointers_.end()) {
+    PointerShard& shard = GetPointerShard(mangled_ptr);
+    std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+    auto entry = shard.pointers.find(mangled_ptr);
+    if (entry == shard.pointers.end()) {
       return 0;
     }
     hash_index = entry->second.hash_index;
@@ -255,9 +266,10 @@ size_t PointerData::GetFrames(const void* ptr, uintptr_t* frames, size_t max_fra
     return 0;
   }
 
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-  auto frame_entry = frames_.find(hash_index);
-  if (frame_entry == frames_.end()) {
+  FrameShard& shard = GetFrameShard(hash_index);
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
+  auto frame_entry = shard.frames.find(hash_index);
+  if (frame_entry == shard.frames.end()) {
     return 0;
   }
   FrameInfoType* frame_info = &frame_entry->second;
@@ -270,16 +282,17 @@ size_t PointerData::GetFrames(const void* ptr, uintptr_t* frames, size_t max_fra
 }
 
 void PointerData::LogBacktrace(size_t hash_index) {
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  FrameShard& shard = GetFrameShard(hash_index);
+  std::lock_guard<std::mutex> frame_guard(shard.mutex);
   if (g_debug->config().options() & BACKTRACE_FULL) {
-    auto backtrace_info_entry = backtraces_info_.find(hash_index);
-    if (backtrace_info_entry != backtraces_info_.end()) {
+    auto backtrace_info_entry = shard.backtraces_info.find(hash_index);
+    if (backtrace_info_entry != shard.backtraces_info.end()) {
       UnwindLog(backtrace_info_entry->second);
       return;
     }
   } else {
-    auto frame_entry = frames_.find(hash_index);
-    if (frame_entry != frames_.end()) {
+    auto frame_entry = shard.frames.find(hash_index);
+    if (frame_entry != shard.frames.end()) {
       FrameInfoType* frame_info = &frame_entry->second;
       backtrace_log(frame_info->frames.data(), frame_info->frames.size());
       return;
@@ -400,41 +413,73 @@ void PointerData::VerifyAllFreed() {
   }
 }
 
-void PointerData::GetList(std::vector<ListInfoType>* list, bool only_with_backtrace)
-    REQUIRES(pointer_mutex_, frame_mutex_) {
-  for (const auto& entry : pointers_) {
-    FrameInfoType* frame_info = nullptr;
-    std::vector<unwindstack::FrameData>* backtrace_info = nullptr;
-    uintptr_t pointer = DemanglePointer(entry.first);
-    size_t hash_index = entry.second.hash_index;
-    if (hash_index > kBacktraceEmptyIndex) {
-      auto frame_entry = frames_.find(hash_index);
-      if (frame_entry == frames_.end()) {
-        // Somehow wound up with a pointer with a valid hash_index, but
-        // no frame data. This should not be possible since adding a pointer
-        // occurs after the hash_index and frame data have been added.
-        // When removing a pointer, the pointer is deleted before the frame
-        // data.
-        error_log("Pointer 0x%" PRIxPTR " hash_index %zu does not exist.", pointer, hash_index);
-      } else {
-        frame_info = &frame_entry->second;
-      }
+void PointerData::LockAllShards() NO_THREAD_SAFETY_ANALYSIS {
+  for (auto& shard : pointer_shards_) {
+    shard.mutex.lock();
+  }
+  for (auto& shard : frame_shards_) {
+    shard.mutex.lock();
+  }
+}
+
+void PointerData::UnlockAllShards() NO_THREAD_SAFETY_ANALYSIS {
+  for (size_t i = kFrameShards; i > 0; i--) {
+    frame_shards_[i - 1].mutex.unlock();
+  }
+  for (size_t i = kPointerShards; i > 0; i--) {
+    pointer_shards_[i - 1].mutex.unlock();
+  }
+}
 
-      if (g_debug->config().options() & BACKTRACE_FULL) {
-        auto backtrace_entry = backtraces_info_.find(hash_index);
-        if (backtrace_entry == backtraces_info_.end()) {
+// Must be called with all of the pointer shards locked.
+bool PointerData::PointersEmpty() NO_THREAD_SAFETY_ANALYSIS {
+  for (const auto& shard : pointer_shards_) {
+    if (!shard.pointers.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Must be called with all of the shards locked.
+void PointerData::GetList(std::vector<ListInfoType>* list, bool only_with_backtrace)
+    NO_THREAD_SAFETY_ANALYSIS {
+  for (const auto& pointer_shard : pointer_shards_) {
+    for (const auto& entry : pointer_shard.pointers) {
+      FrameInfoType* frame_info = nullptr;
+      std::vector<unwindstack::FrameData>* backtrace_info = nullptr;
+      uintptr_t pointer = DemanglePointer(entry.first);
+      size_t hash_index = entry.second.hash_index;
+      if (hash_index > kBacktraceEmptyIndex) {
+        FrameShard& frame_shard = GetFrameShard(hash_index);
+        auto frame_entry = frame_shard.frames.find(hash_index);
+        if (frame_entry == frame_shard.frames.end()) {
+          // Somehow wound up with a pointer with a valid hash_index, but
+          // no frame data. This should not be possible since adding a pointer
+          // occurs after the hash_index and frame data have been added.
+          // When removing a pointer, the pointer is deleted before the frame
+          // data.
           error_log("Pointer 0x%" PRIxPTR " hash_index %zu does not exist.", pointer, hash_index);
         } else {
-          backtrace_info = &backtrace_entry->second;
+          frame_info = &frame_entry->second;
+        }
+
+        if (g_debug->config().options() & BACKTRACE_FULL) {
+          auto backtrace_entry = frame_shard.backtraces_info.find(hash_index);
+          if (backtrace_entry == frame_shard.backtraces_info.end()) {
+            error_log("Pointer 0x%" PRIxPTR " hash_index %zu does not exist.", pointer, hash_index);
+          } else {
+            backtrace_info = &backtrace_entry->second;
+          }
         }
       }
-    }
-    if (hash_index == 0 && only_with_backtrace) {
-      continue;
-    }
+      if (hash_index == 0 && only_with_backtrace) {
+        continue;
+      }
 
-    list->emplace_back(ListInfoType{pointer, 1, entry.second.RealSize(),
-                                    entry.second.ZygoteChildAlloc(), frame_info, backtrace_info});
+      list->emplace_back(ListInfoType{pointer, 1, entry.second.RealSize(),
+                                      entry.second.ZygoteChildAlloc(), frame_info, backtrace_info});
+    }
   }
 
   // Sort by the size of the allocation.
@@ -473,8 +518,9 @@ void PointerData::GetList(std::vector<ListInfoType>* list, bool only_with_backtr
   });
 }
 
+// Must be called with all of the shards locked.
 void PointerData::GetUniqueList(std::vector<ListInfoType>* list, bool only_with_backtrace)
-    REQUIRES(pointer_mutex_, frame_mutex_) {
+    NO_THREAD_SAFETY_ANALYSIS {
   GetList(list, only_with_backtrace);
 
   // Remove duplicates of size/backtraces.
@@ -497,8 +543,7 @@ void PointerData::GetUniqueList(std::vector<ListInfoType>* list, bool only_with_
 void PointerData::LogLeaks() {
   std::vector<ListInfoType> list;
 
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  LockAllShards();
   GetList(&list, false);
 
   size_t track_count = 0;
@@ -514,25 +559,28 @@ void PointerData::LogLeaks() {
     }
     // Do not bother to free the pointers, we are about to exit any way.
   }
+  UnlockAllShards();
 }
 
 void PointerData::GetAllocList(std::vector<ListInfoType>* list) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
-
-  if (pointers_.empty()) {
-    return;
+  LockAllShards();
+  if (!PointersEmpty()) {
+    GetList(list, false);
   }
-
-  GetList(list, false);
+  UnlockAllShards();
 }
 
 void PointerData::GetInfo(uint8_t** info, size_t* overall_size, size_t* info_size,
                           size_t* total_memory, size_t* backtrace_size) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+  LockAllShards();
+  GetInfoLocked(info, overall_size, info_size, total_memory, backtrace_size);
+  UnlockAllShards();
+}
 
-  if (pointers_.empty()) {
+// Must be called with all of the shards locked.
+void PointerData::GetInfoLocked(uint8_t** info, size_t* overall_size, size_t* info_size,
+                                size_t* total_memory, size_t* backtrace_size) {
+  if (PointersEmpty()) {
     return;
   }
 
@@ -568,16 +616,21 @@ void PointerData::GetInfo(uint8_t** info, size_t* overall_size, size_t* info_siz
 }
 
 bool PointerData::Exists(const void* ptr) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
   uintptr_t mangled_ptr = ManglePointer(reinterpret_cast<uintptr_t>(ptr));
-  return pointers_.count(mangled_ptr) != 0;
+  PointerShard& shard = GetPointerShard(mangled_ptr);
+  std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+  return shard.pointers.count(mangled_ptr) != 0;
 }
 
 void PointerData::DumpLiveToFile(int fd) {
-  std::vector<ListInfoType> list;
+  LockAllShards();
+  DumpLiveToFileLocked(fd);
+  UnlockAllShards();
+}
 
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  std::lock_guard<std::mutex> frame_guard(frame_mutex_);
+// Must be called with all of the shards locked.
+void PointerData::DumpLiveToFileLocked(int fd) {
+  std::vector<ListInfoType> list;
   GetUniqueList(&list, false);
 
   size_t total_memory = 0;
@@ -633,32 +686,121 @@ void PointerData::DumpLiveToFile(int fd) {
   }
 }
 
+bool PointerData::DumpLiveToFileBinary(int fd) {
+  LockAllShards();
+  bool result = DumpLiveToFileBinaryLocked(fd);
+  UnlockAllShards();
+  return result;
+}
+
+// Accumulates output so that the dump isn't made of millions of tiny writes.
+class BufferedWriter {
+ public:
+  explicit BufferedWriter(int fd) : fd_(fd) { buffer_.reserve(kBufferSize); }
+
+  template <typename T>
+  void Write(T value) {
+    Write(&value, sizeof(value));
+  }
+
+  void Write(const void* data, size_t size) {
+    if (buffer_.size() + size > kBufferSize) {
+      Flush();
+    }
+    buffer_.append(reinterpret_cast<const char*>(data), size);
+  }
+
+  bool Flush() {
+    if (!buffer_.empty() && !android::base::WriteFully(fd_, buffer_.data(), buffer_.size())) {
+      ok_ = false;
+    }
+    buffer_.clear();
+    return ok_;
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 64 * 1024;
+
+  int fd_;
+  bool ok_ = true;
+  std::string buffer_;
+};
+
+// Must be called with all of the shards locked.
+//
+// Writes the stack table and the allocation records of a binary heap dump,
+// see the README for the layout. Every unique backtrace is written once and
+// the records refer to it by index.
+bool PointerData::DumpLiveToFileBinaryLocked(int fd) {
+  std::vector<ListInfoType> list;
+  GetUniqueList(&list, false);
+
+  std::unordered_map<const FrameInfoType*, uint32_t> stack_indexes;
+  std::vector<const FrameInfoType*> stacks;
+  size_t total_memory = 0;
+  for (const auto& info : list) {
+    total_memory += info.size * info.num_allocations;
+    if (info.frame_info != nullptr && stack_indexes.count(info.frame_info) == 0) {
+      stack_indexes.emplace(info.frame_info, stacks.size());
+      stacks.push_back(info.frame_info);
+    }
+  }
+
+  BufferedWriter writer(fd);
+  writer.Write<uint64_t>(total_memory);
+  writer.Write<uint32_t>(g_debug->config().backtrace_frames());
+
+  writer.Write<uint32_t>(stacks.size());
+  for (const FrameInfoType* frame_info : stacks) {
+    writer.Write<uint32_t>(frame_info->frames.size());
+    for (uintptr_t frame : frame_info->frames) {
+      writer.Write<uint64_t>(frame);
+    }
+  }
+
+  writer.Write<uint64_t>(list.size());
+  for (const auto& info : list) {
+    writer.Write<uint64_t>(info.size);
+    writer.Write<uint64_t>(info.num_allocations);
+    writer.Write<uint32_t>(info.frame_info != nullptr ? stack_indexes[info.frame_info]
+                                                      : kBinaryDumpNoStack);
+    writer.Write<uint32_t>(info.zygote_child_alloc ? kBinaryDumpZygoteChild : 0);
+  }
+  return writer.Flush();
+}
+
 void PointerData::PrepareFork() NO_THREAD_SAFETY_ANALYSIS {
   free_pointer_mutex_.lock();
-  pointer_mutex_.lock();
-  frame_mutex_.lock();
+  LockAllShards();
 }
 
 void PointerData::PostForkParent() NO_THREAD_SAFETY_ANALYSIS {
-  frame_mutex_.unlock();
-  pointer_mutex_.unlock();
+  UnlockAllShards();
   free_pointer_mutex_.unlock();
 }
 
 void PointerData::PostForkChild() __attribute__((no_thread_safety_analysis)) {
   // Make sure that any potential mutexes have been released and are back
   // to an initial state.
-  frame_mutex_.try_lock();
-  frame_mutex_.unlock();
-  pointer_mutex_.try_lock();
-  pointer_mutex_.unlock();
+  for (auto& shard : frame_shards_) {
+    shard.mutex.try_lock();
+    shard.mutex.unlock();
+  }
+  for (auto& shard : pointer_shards_) {
+    shard.mutex.try_lock();
+    shard.mutex.unlock();
+  }
   free_pointer_mutex_.try_lock();
   free_pointer_mutex_.unlock();
 }
 
 void PointerData::IteratePointers(std::function<void(uintptr_t pointer)> fn) {
-  std::lock_guard<std::mutex> pointer_guard(pointer_mutex_);
-  for (const auto entry : pointers_) {
-    fn(DemanglePointer(entry.first));
+  // Callers stop all allocations first, so there's no need to hold every
+  // shard at once.
+  for (auto& shard : pointer_shards_) {
+    std::lock_guard<std::mutex> pointer_guard(shard.mutex);
+    for (const auto entry : shard.pointers) {
+      fn(DemanglePointer(entry.first));
+    }
   }
 }
@@ -104,6 +104,10 @@ struct FreePointerInfoType {
   size_t hash_index;
 };
 
+// Values used in the allocation records of a binary heap dump.
+constexpr uint32_t kBinaryDumpNoStack = UINT32_MAX;
+constexpr uint32_t kBinaryDumpZygoteChild = 0x1;
+
 struct ListInfoType {
   uintptr_t pointer;
   size_t num_allocations;
@@ -152,6 +156,7 @@ class PointerData : public OptionData {
   static void GetAllocList(std::vector<ListInfoType>* list);
   static void LogLeaks();
   static void DumpLiveToFile(int fd);
+  static bool DumpLiveToFileBinary(int fd);
 
   static void GetInfo(uint8_t** info, size_t* overall_size, size_t* info_size, size_t* total_memory,
                       size_t* backtrace_size);
@@ -167,9 +172,50 @@ class PointerData : public OptionData {
   static inline uintptr_t ManglePointer(uintptr_t pointer) { return pointer ^ UINTPTR_MAX; }
   static inline uintptr_t DemanglePointer(uintptr_t pointer) { return pointer ^ UINTPTR_MAX; }
 
+  // The live pointer and backtrace tables are split into independently
+  // locked shards so that threads allocating at the same time rarely contend.
+  // Operations that need a consistent view of everything (leak dumps, heap
+  // info, fork) lock every pointer shard and then every frame shard, always
+  // in index order.
+  static constexpr size_t kPointerShards = 64;
+  static constexpr size_t kFrameShards = 16;
+
+  struct alignas(64) PointerShard {
+    std::mutex mutex;
+    std::unordered_map<uintptr_t, PointerInfoType> pointers;
+  };
+
+  // A hash index encodes the frame shard that owns it in its low bits, so
+  // that a pointer's hash index is enough to find its frame data.
+  struct alignas(64) FrameShard {
+    std::mutex mutex;
+    std::unordered_map<FrameKeyType, size_t> key_to_index;
+    std::unordered_map<size_t, FrameInfoType> frames;
+    std::unordered_map<size_t, std::vector<unwindstack::FrameData>> backtraces_info;
+    size_t next_index;
+  };
+
+  static inline PointerShard& GetPointerShard(uintptr_t mangled_ptr) {
+    // Allocations are at least 8 byte aligned, so skip the low bits.
+    uintptr_t pointer = DemanglePointer(mangled_ptr) >> 3;
+    return pointer_shards_[(pointer ^ (pointer >> 8)) % kPointerShards];
+  }
+  static inline FrameShard& GetFrameShard(size_t hash_index) {
+    return frame_shards_[hash_index % kFrameShards];
+  }
+
+  static void LockAllShards();
+  static void UnlockAllShards();
+  static bool PointersEmpty();
+
   static std::string GetHashString(uintptr_t* frames, size_t num_frames);
   static void LogBacktrace(size_t hash_index);
 
+  static void GetInfoLocked(uint8_t** info, size_t* overall_size, size_t* info_size,
+                            size_t* total_memory, size_t* backtrace_size);
+  static void DumpLiveToFileLocked(int fd);
+  static bool DumpLiveToFileBinaryLocked(int fd);
+
   static void GetList(std::vector<ListInfoType>* list, bool only_with_backtrace);
   static void GetUniqueList(std::vector<ListInfoType>* list, bool only_with_backtrace);
 
@@ -180,14 +226,9 @@ class PointerData : public OptionData {
 
   static std::atomic_bool backtrace_dump_;
 
-  static std::mutex pointer_mutex_;
-  static std::unordered_map<uintptr_t, PointerInfoType> pointers_;
+  static PointerShard pointer_shards_[kPointerShards];
 
-  static std::mutex frame_mutex_;
-  static std::unordered_map<FrameKeyType, size_t> key_to_index_;
-  static std::unordered_map<size_t, FrameInfoType> frames_;
-  static std::unordered_map<size_t, std::vector<unwindstack::FrameData>> backtraces_info_;
-  static size_t cur_hash_index_;
+  static FrameShard frame_shards_[kFrameShards];
 
   static std::mutex free_pointer_mutex_;
   static std::deque<FreePointerInfoType> free_pointers_;
@@ -34,8 +34,12 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 
 #include <android-base/stringprintf.h>
@@ -46,66 +50,113 @@
 #include "debug_disable.h"
 #include "debug_log.h"
 
-RecordEntry::RecordEntry() : tid_(gettid()) {
+RecordEntry::RecordEntry(RecordType type) : type_(type), tid_(gettid()) {}
+
+bool RecordEntry::Write(int fd) const {
+  switch (type_) {
+    case RECORD_THREAD_DONE:
+      return dprintf(fd, "%d: thread_done 0x0\n", tid_) > 0;
+    case RECORD_MALLOC:
+      return dprintf(fd, "%d: malloc %p %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, size_,
+                     start_ns_, end_ns_) > 0;
+    case RECORD_FREE:
+      return dprintf(fd, "%d: free %p %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, start_ns_,
+                     end_ns_) > 0;
+    case RECORD_CALLOC:
+      return dprintf(fd, "%d: calloc %p %zu %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
+                     static_cast<size_t>(arg_), size_, start_ns_, end_ns_) > 0;
+    case RECORD_REALLOC:
+      return dprintf(fd, "%d: realloc %p %p %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
+                     reinterpret_cast<void*>(arg_), size_, start_ns_, end_ns_) > 0;
+    case RECORD_MEMALIGN:
+      return dprintf(fd, "%d: memalign %p %zu %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
+                     static_cast<size_t>(arg_), size_, start_ns_, end_ns_) > 0;
+  }
+  return false;
 }
 
-bool ThreadCompleteEntry::Write(int fd) const {
-  return dprintf(fd, "%d: thread_done 0x0\n", tid_) > 0;
+bool RecordEntry::operator<(const RecordEntry& other) const {
+  return sequence_ < other.sequence_;
 }
 
-AllocEntry::AllocEntry(void* pointer, uint64_t start_ns, uint64_t end_ns)
-    : pointer_(pointer), start_ns_(start_ns), end_ns_(end_ns) {}
+ThreadCompleteEntry::ThreadCompleteEntry() : RecordEntry(RECORD_THREAD_DONE) {}
 
 MallocEntry::MallocEntry(void* pointer, size_t size, uint64_t start_ns, uint64_t end_ns)
-    : AllocEntry(pointer, start_ns, end_ns), size_(size) {}
-
-bool MallocEntry::Write(int fd) const {
-  return dprintf(fd, "%d: malloc %p %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, size_,
-                 start_ns_, end_ns_) > 0;
+    : RecordEntry(RECORD_MALLOC) {
+  pointer_ = pointer;
+  size_ = size;
+  start_ns_ = start_ns;
+  end_ns_ = end_ns;
 }
 
 FreeEntry::FreeEntry(void* pointer, uint64_t start_ns, uint64_t end_ns)
-    : AllocEntry(pointer, start_ns, end_ns) {}
-
-bool FreeEntry::Write(int fd) const {
-  return dprintf(fd, "%d: free %p %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, start_ns_, end_ns_) >
-         0;
+    : RecordEntry(RECORD_FREE) {
+  pointer_ = pointer;
+  start_ns_ = start_ns;
+  end_ns_ = end_ns;
 }
 
 CallocEntry::CallocEntry(void* pointer, size_t nmemb, size_t size, uint64_t start_ns,
                          uint64_t end_ns)
-    : MallocEntry(pointer, size, start_ns, end_ns), nmemb_(nmemb) {}
-
-bool CallocEntry::Write(int fd) const {
-  return dprintf(fd, "%d: calloc %p %zu %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_, nmemb_,
-                 size_, start_ns_, end_ns_) > 0;
+    : RecordEntry(RECORD_CALLOC) {
+  pointer_ = pointer;
+  size_ = size;
+  arg_ = nmemb;
+  start_ns_ = start_ns;
+  end_ns_ = end_ns;
 }
 
 ReallocEntry::ReallocEntry(void* pointer, size_t size, void* old_pointer, uint64_t start_ns,
                            uint64_t end_ns)
-    : MallocEntry(pointer, size, start_ns, end_ns), old_pointer_(old_pointer) {}
-
-bool ReallocEntry::Write(int fd) const {
-  return dprintf(fd, "%d: realloc %p %p %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
-                 old_pointer_, size_, start_ns_, end_ns_) > 0;
+    : RecordEntry(RECORD_REALLOC) {
+  pointer_ = pointer;
+  size_ = size;
+  arg_ = reinterpret_cast<uintptr_t>(old_pointer);
+  start_ns_ = start_ns;
+  end_ns_ = end_ns;
 }
 
 // aligned_alloc, posix_memalign, memalign, pvalloc, valloc all recorded with this class.
 MemalignEntry::MemalignEntry(void* pointer, size_t size, size_t alignment, uint64_t start_ns,
                              uint64_t end_ns)
-    : MallocEntry(pointer, size, start_ns, end_ns), alignment_(alignment) {}
-
-bool MemalignEntry::Write(int fd) const {
-  return dprintf(fd, "%d: memalign %p %zu %zu %" PRIu64 " %" PRIu64 "\n", tid_, pointer_,
-                 alignment_, size_, start_ns_, end_ns_) > 0;
+    : RecordEntry(RECORD_MEMALIGN) {
+  pointer_ = pointer;
+  size_ = size;
+  arg_ = alignment;
+  start_ns_ = start_ns;
+  end_ns_ = end_ns;
 }
 
+// Every thread first records into its own ring of entries, which needs no
+// lock. The ring is only moved into the shared entries when it fills up, when
+// the thread exits, or when the records are written out.
+static constexpr size_t kThreadEntries = 256;
+
 struct ThreadData {
-  ThreadData(RecordData* record_data, ThreadCompleteEntry* entry)
-      : record_data(record_data), entry(entry) {}
+  explicit ThreadData(RecordData* record_data) : record_data(record_data) {}
   RecordData* record_data;
-  ThreadCompleteEntry* entry;
   size_t count = 0;
+
+  // Linked through RecordData::threads_, under RecordData::entries_lock_.
+  ThreadData* prev = nullptr;
+  ThreadData* next = nullptr;
+
+  // Only the owning thread advances head, and tail is only advanced with
+  // RecordData::entries_lock_ held.
+  std::atomic<size_t> head = 0;
+  std::atomic<size_t> tail = 0;
+  RecordEntry entries[kThreadEntries];
+
+  void Add(const RecordEntry& entry, uint64_t sequence) {
+    size_t cur_head = head.load(std::memory_order_relaxed);
+    if (cur_head - tail.load(std::memory_order_acquire) == kThreadEntries) {
+      record_data->FlushThread(this);
+    }
+    RecordEntry& slot = entries[cur_head % kThreadEntries];
+    slot = entry;
+    slot.sequence_ = sequence;
+    head.store(cur_head + 1, std::memory_order_release);
+  }
 };
 
 static void ThreadKeyDelete(void* data) {
@@ -117,7 +168,8 @@ static void ThreadKeyDelete(void* data) {
   if (thread_data->count == 4) {
     ScopedDisableDebugCalls disable;
 
-    thread_data->record_data->AddEntryOnly(thread_data->entry);
+    thread_data->Add(ThreadCompleteEntry(), RecordData::NextSequence());
+    thread_data->record_data->RemoveThread(thread_data);
     delete thread_data;
   } else {
     pthread_setspecific(thread_data->record_data->key(), data);
@@ -125,6 +177,7 @@ static void ThreadKeyDelete(void* data) {
 }
 
 RecordData* RecordData::record_obj_ = nullptr;
+std::atomic<uint64_t> RecordData::next_sequence_ = 0;
 
 void RecordData::WriteData(int, siginfo_t*, void*) {
   // Dump from here, the function must not allocate so this is safe.
@@ -133,11 +186,20 @@ void RecordData::WriteData(int, siginfo_t*, void*) {
 
 void RecordData::WriteEntries() {
   std::lock_guard<std::mutex> entries_lock(entries_lock_);
+  for (ThreadData* thread_data = threads_; thread_data != nullptr;
+       thread_data = thread_data->next) {
+    FlushThreadLocked(thread_data);
+  }
   if (cur_index_ == 0) {
     info_log("No alloc entries to write.");
     return;
   }
 
+  // Each thread's entries were added a buffer at a time, so put them back in
+  // call order; replaying the file needs every pointer's allocation to come
+  // before its free or realloc. std::sort doesn't allocate.
+  std::sort(entries_, entries_ + cur_index_);
+
   int dump_fd =
       open(dump_file_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0755);
   if (dump_fd == -1) {
@@ -146,7 +208,7 @@ void RecordData::WriteEntries() {
   }
 
   for (size_t i = 0; i < cur_index_; i++) {
-    if (!entries_[i]->Write(dump_fd)) {
+    if (!entries_[i].Write(dump_fd)) {
       error_log("Failed to write record alloc information: %s", strerror(errno));
       break;
     }
@@ -177,7 +239,18 @@ bool RecordData::Initialize(const Config& config) {
              config.record_allocs_signal(), getpid());
   }
 
-  entries_.resize(config.record_allocs_num_entries());
+  // Only the pages that records are written to are ever touched, so map the
+  // space rather than allocating it.
+  num_entries_ = config.record_allocs_num_entries();
+  void* map = mmap(nullptr, num_entries_ * sizeof(RecordEntry), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (map == MAP_FAILED) {
+    error_log("Unable to allocate %zu record entries: %s", num_entries_, strerror(errno));
+    return false;
+  }
+  prctl(PR_SET_VMA, PR_SET_VMA_ANON_NAME, map, num_entries_ * sizeof(RecordEntry),
+        "malloc_debug record_allocs");
+  entries_ = reinterpret_cast<RecordEntry*>(map);
   cur_index_ = 0U;
   dump_file_ = config.record_allocs_file();
 
@@ -186,27 +259,58 @@ bool RecordData::Initialize(const Config& config) {
 
 RecordData::~RecordData() {
   pthread_key_delete(key_);
+  if (entries_ != nullptr) {
+    munmap(entries_, num_entries_ * sizeof(RecordEntry));
+  }
 }
 
-void RecordData::AddEntryOnly(const RecordEntry* entry) {
-  std::lock_guard<std::mutex> entries_lock(entries_lock_);
-  if (cur_index_ == entries_.size()) {
-    // Maxed out, throw the entry away.
-    return;
+void RecordData::FlushThreadLocked(ThreadData* thread_data) {
+  size_t head = thread_data->head.load(std::memory_order_acquire);
+  size_t tail = thread_data->tail.load(std::memory_order_relaxed);
+  for (; tail != head; tail++) {
+    if (cur_index_ == num_entries_) {
+      // Maxed out, throw the entries away.
+      break;
+    }
+    entries_[cur_index_++] = thread_data->entries[tail % kThreadEntries];
+    if (cur_index_ == num_entries_) {
+      info_log("Maximum number of records added, all new operations will be dropped.");
+    }
   }
+  thread_data->tail.store(head, std::memory_order_release);
+}
 
-  entries_[cur_index_++].reset(entry);
-  if (cur_index_ == entries_.size()) {
-    info_log("Maximum number of records added, all new operations will be dropped.");
+void RecordData::FlushThread(ThreadData* thread_data) {
+  std::lock_guard<std::mutex> entries_lock(entries_lock_);
+  FlushThreadLocked(thread_data);
+}
+
+void RecordData::RemoveThread(ThreadData* thread_data) {
+  std::lock_guard<std::mutex> entries_lock(entries_lock_);
+  FlushThreadLocked(thread_data);
+  if (thread_data->prev != nullptr) {
+    thread_data->prev->next = thread_data->next;
+  } else {
+    threads_ = thread_data->next;
+  }
+  if (thread_data->next != nullptr) {
+    thread_data->next->prev = thread_data->prev;
   }
 }
 
-void RecordData::AddEntry(const RecordEntry* entry) {
-  void* data = pthread_getspecific(key_);
-  if (data == nullptr) {
-    ThreadData* thread_data = new ThreadData(this, new ThreadCompleteEntry());
+void RecordData::AddEntry(const RecordEntry& entry, uint64_t sequence) {
+  ThreadData* thread_data = reinterpret_cast<ThreadData*>(pthread_getspecific(key_));
+  if (thread_data == nullptr) {
+    thread_data = new ThreadData(this);
     pthread_setspecific(key_, thread_data);
+
+    std::lock_guard<std::mutex> entries_lock(entries_lock_);
+    thread_data->next = threads_;
+    if (threads_ != nullptr) {
+      threads_->prev = thread_data;
+    }
+    threads_ = thread_data;
   }
 
-  AddEntryOnly(entry);
+  thread_data->Add(entry, sequence);
 }
@@ -34,123 +34,85 @@
 #include <unistd.h>
 
 #include <atomic>
-#include <memory>
 #include <mutex>
 #include <string>
-#include <vector>
 
 #include <platform/bionic/macros.h>
 
+enum RecordType : uint8_t {
+  RECORD_THREAD_DONE,
+  RECORD_MALLOC,
+  RECORD_FREE,
+  RECORD_CALLOC,
+  RECORD_REALLOC,
+  RECORD_MEMALIGN,
+};
+
+// A fixed size record of one allocation call. Entries are copied around by
+// value, the subclasses only exist to fill in the fields for each call.
 class RecordEntry {
  public:
-  RecordEntry();
-  virtual ~RecordEntry() = default;
+  RecordEntry() = default;
+
+  bool Write(int fd) const;
 
-  virtual bool Write(int fd) const = 0;
+  // Orders entries by when the call was made.
+  bool operator<(const RecordEntry& other) const;
 
  protected:
-  pid_t tid_;
+  explicit RecordEntry(RecordType type);
 
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(RecordEntry);
-};
+  RecordType type_ = RECORD_THREAD_DONE;
+  pid_t tid_ = 0;
+  void* pointer_ = nullptr;
+  size_t size_ = 0;
+  // The element count for calloc, the alignment for memalign and the old
+  // pointer for realloc.
+  uintptr_t arg_ = 0;
 
-class ThreadCompleteEntry : public RecordEntry {
- public:
-  ThreadCompleteEntry() = default;
-  virtual ~ThreadCompleteEntry() = default;
+  // The start/end time of this operation.
+  uint64_t start_ns_ = 0;
+  uint64_t end_ns_ = 0;
 
-  bool Write(int fd) const override;
+  // The position of this entry among all recorded calls, on any thread.
+  uint64_t sequence_ = 0;
 
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(ThreadCompleteEntry);
+  friend struct ThreadData;
 };
 
-class AllocEntry : public RecordEntry {
+class ThreadCompleteEntry : public RecordEntry {
  public:
-  explicit AllocEntry(void* pointer, uint64_t st, uint64_t et);
-  virtual ~AllocEntry() = default;
-
- protected:
-  void* pointer_;
-
-  // The start/end time of this operation.
-  uint64_t start_ns_;
-  uint64_t end_ns_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(AllocEntry);
+  ThreadCompleteEntry();
 };
 
-class MallocEntry : public AllocEntry {
+class MallocEntry : public RecordEntry {
  public:
   MallocEntry(void* pointer, size_t size, uint64_t st, uint64_t et);
-  virtual ~MallocEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  size_t size_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(MallocEntry);
 };
 
-class FreeEntry : public AllocEntry {
+class FreeEntry : public RecordEntry {
  public:
-  explicit FreeEntry(void* pointer, uint64_t st, uint64_t et);
-  virtual ~FreeEntry() = default;
-
-  bool Write(int fd) const override;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(FreeEntry);
+  FreeEntry(void* pointer, uint64_t st, uint64_t et);
 };
 
-class CallocEntry : public MallocEntry {
+class CallocEntry : public RecordEntry {
  public:
   CallocEntry(void* pointer, size_t nmemb, size_t size, uint64_t st, uint64_t et);
-  virtual ~CallocEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  size_t nmemb_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(CallocEntry);
 };
 
-class ReallocEntry : public MallocEntry {
+class ReallocEntry : public RecordEntry {
  public:
   ReallocEntry(void* pointer, size_t size, void* old_pointer, uint64_t st, uint64_t et);
-  virtual ~ReallocEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  void* old_pointer_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(ReallocEntry);
 };
 
 // aligned_alloc, posix_memalign, memalign, pvalloc, valloc all recorded with this class.
-class MemalignEntry : public MallocEntry {
+class MemalignEntry : public RecordEntry {
  public:
   MemalignEntry(void* pointer, size_t size, size_t alignment, uint64_t st, uint64_t et);
-  virtual ~MemalignEntry() = default;
-
-  bool Write(int fd) const override;
-
- protected:
-  size_t alignment_;
-
- private:
-  BIONIC_DISALLOW_COPY_AND_ASSIGN(MemalignEntry);
 };
 
 class Config;
+struct ThreadData;
 
 class RecordData {
  public:
@@ -159,20 +121,40 @@ class RecordData {
 
   bool Initialize(const Config& config);
 
-  void AddEntry(const RecordEntry* entry);
-  void AddEntryOnly(const RecordEntry* entry);
+  // Returns the next position in the order of all recorded calls. A free
+  // must take its position before the memory is released, or another thread
+  // could reuse the memory and record the new allocation first. Allocations
+  // take theirs once the allocator has returned.
+  static uint64_t NextSequence() {
+    return next_sequence_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void AddEntry(const RecordEntry& entry) { AddEntry(entry, NextSequence()); }
+  void AddEntry(const RecordEntry& entry, uint64_t sequence);
 
   pthread_key_t key() { return key_; }
 
+  // Called when the thread owning thread_data is exiting.
+  void RemoveThread(ThreadData* thread_data);
+  // Moves the records buffered by thread_data into entries_.
+  void FlushThread(ThreadData* thread_data);
+
  private:
   static void WriteData(int, siginfo_t*, void*);
   static RecordData* record_obj_;
+  static std::atomic<uint64_t> next_sequence_;
 
   void WriteEntries();
+  void FlushThreadLocked(ThreadData* thread_data);
 
+  // Only taken to move a thread's buffered records into entries_, to add or
+  // remove a thread, and to write the entries out.
   std::mutex entries_lock_;
   pthread_key_t key_;
-  std::vector<std::unique_ptr<const RecordEntry>> entries_;
+  // All threads that have buffered records.
+  ThreadData* threads_ = nullptr;
+  RecordEntry* entries_ = nullptr;
+  size_t num_entries_ = 0;
   size_t cur_index_;
   std::string dump_file_;
 
@@ -37,6 +37,8 @@
 #include <unistd.h>
 #include <unwind.h>
 
+#include <platform/bionic/android_unsafe_frame_pointer_chase.h>
+
 #include "MapData.h"
 #include "backtrace.h"
 #include "debug_log.h"
@@ -77,11 +79,7 @@ struct stack_crawl_state_t {
       : frames(frames), frame_count(frame_count) {}
 };
 
-static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg) {
-  stack_crawl_state_t* state = static_cast<stack_crawl_state_t*>(arg);
-
-  uintptr_t ip = _Unwind_GetIP(context);
-
+static uintptr_t adjust_return_address(uintptr_t ip) {
   // `ip` is the address of the instruction *after* the call site in
   // `context`, so we want to back up by one instruction. This is hard for
   // every architecture except arm64, so we just make sure we're *inside*
@@ -96,9 +94,20 @@ static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg)
     ip -= 1;  // At least.
 #endif
   }
+  return ip;
+}
+
+static bool in_current_code_map(uintptr_t ip) {
+  return g_current_code_map && (ip >= g_current_code_map->start) && ip < g_current_code_map->end;
+}
+
+static _Unwind_Reason_Code trace_function(__unwind_context* context, void* arg) {
+  stack_crawl_state_t* state = static_cast<stack_crawl_state_t*>(arg);
+
+  uintptr_t ip = adjust_return_address(_Unwind_GetIP(context));
 
   // Do not record the frames that fall in our own shared library.
-  if (g_current_code_map && (ip >= g_current_code_map->start) && ip < g_current_code_map->end) {
+  if (in_current_code_map(ip)) {
     return _URC_NO_REASON;
   }
 
@@ -112,6 +121,35 @@ size_t backtrace_get(uintptr_t* frames, size_t frame_count) {
   return state.cur_frame;
 }
 
+// The frames that malloc debug itself adds on top of the caller's are
+// discarded, so gather a few more than were asked for.
+static constexpr size_t kMaxOwnFrames = 16;
+static constexpr size_t kMaxFpFrames = 256 + kMaxOwnFrames;
+
+size_t backtrace_get_fp(uintptr_t* frames, size_t frame_count) {
+  // Only return addresses are collected here. Symbolization happens when
+  // the backtrace is logged or dumped, just as for backtrace_get().
+  uintptr_t raw_frames[kMaxFpFrames];
+  size_t raw_count = frame_count + kMaxOwnFrames;
+  if (raw_count > kMaxFpFrames) {
+    raw_count = kMaxFpFrames;
+  }
+  size_t available = android_unsafe_frame_pointer_chase(raw_frames, raw_count);
+  if (available < raw_count) {
+    raw_count = available;
+  }
+
+  size_t cur_frame = 0;
+  for (size_t i = 0; i < raw_count && cur_frame < frame_count; i++) {
+    uintptr_t ip = adjust_return_address(raw_frames[i]);
+    if (in_current_code_map(ip)) {
+      continue;
+    }
+    frames[cur_frame++] = ip;
+  }
+  return cur_frame;
+}
+
 std::string backtrace_string(const uintptr_t* frames, size_t frame_count) {
   std::string str;
 
@@ -162,6 +162,8 @@ static TimedResult TimerCallVoid(MallocFn fn, Args... args) {
 #define TCALL(FUNC, ...) TimerCall(&MallocDispatch::FUNC, __VA_ARGS__);
 #define TCALLVOID(FUNC, ...) TimerCallVoid(&MallocDispatch::FUNC, __VA_ARGS__);
 
+static void DumpHeapWithPrefix(const char* suffix);
+
 // ------------------------------------------------------------------------
 
 // ------------------------------------------------------------------------
@@ -183,6 +185,8 @@ void debug_free_malloc_leak_info(uint8_t* info);
 size_t debug_malloc_usable_size(void* pointer);
 void* debug_malloc(size_t size);
 void debug_free(void* pointer);
+void debug_free_sized(void* pointer, size_t bytes);
+void debug_free_aligned_sized(void* pointer, size_t alignment, size_t bytes);
 void* debug_aligned_alloc(size_t alignment, size_t size);
 void* debug_memalign(size_t alignment, size_t bytes);
 void* debug_realloc(void* pointer, size_t bytes);
@@ -451,9 +455,7 @@ void debug_finalize() {
   }
 
   if ((g_debug->config().options() & BACKTRACE) && g_debug->config().backtrace_dump_on_exit()) {
-    debug_dump_heap(android::base::StringPrintf("%s.%d.exit.txt",
-                                                g_debug->config().backtrace_dump_prefix().c_str(),
-                                                getpid()).c_str());
+    DumpHeapWithPrefix(".exit");
   }
 
   backtrace_shutdown();
@@ -518,9 +520,7 @@ size_t debug_malloc_usable_size(void* pointer) {
 
 static TimedResult InternalMalloc(size_t size) {
   if ((g_debug->config().options() & BACKTRACE) && g_debug->pointer->ShouldDumpAndReset()) {
-    debug_dump_heap(android::base::StringPrintf(
-                        "%s.%d.txt", g_debug->config().backtrace_dump_prefix().c_str(), getpid())
-                        .c_str());
+    DumpHeapWithPrefix("");
   }
 
   if (size == 0) {
@@ -585,18 +585,21 @@ void* debug_malloc(size_t size) {
   TimedResult result = InternalMalloc(size);
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
-    g_debug->record->AddEntry(new MallocEntry(result.getValue<void*>(), size,
-                                              result.GetStartTimeNS(), result.GetEndTimeNS()));
+    g_debug->record->AddEntry(MallocEntry(result.getValue<void*>(), size,
+                                          result.GetStartTimeNS(), result.GetEndTimeNS()));
   }
 
   return result.getValue<void*>();
 }
 
+// The position of a call in the allocation records, see RecordData::NextSequence().
+static uint64_t RecordSequence() {
+  return (g_debug->config().options() & RECORD_ALLOCS) ? RecordData::NextSequence() : 0;
+}
+
 static TimedResult InternalFree(void* pointer) {
   if ((g_debug->config().options() & BACKTRACE) && g_debug->pointer->ShouldDumpAndReset()) {
-    debug_dump_heap(android::base::StringPrintf(
-                        "%s.%d.txt", g_debug->config().backtrace_dump_prefix().c_str(), getpid())
-                        .c_str());
+    DumpHeapWithPrefix("");
   }
 
   void* free_pointer = pointer;
@@ -667,14 +670,26 @@ void debug_free(void* pointer) {
     return;
   }
 
+  // Taken before the memory can be reused, see RecordData::NextSequence().
+  uint64_t sequence = RecordSequence();
   TimedResult result = InternalFree(pointer);
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
-    g_debug->record->AddEntry(
-        new FreeEntry(pointer, result.GetStartTimeNS(), result.GetEndTimeNS()));
+    g_debug->record->AddEntry(FreeEntry(pointer, result.GetStartTimeNS(), result.GetEndTimeNS()),
+                              sequence);
   }
 }
 
+// The header and guards make the real allocation a different size from the
+// one the caller knows about, so the sized frees are plain frees.
+void debug_free_sized(void* pointer, size_t) {
+  debug_free(pointer);
+}
+
+void debug_free_aligned_sized(void* pointer, size_t, size_t) {
+  debug_free(pointer);
+}
+
 void* debug_memalign(size_t alignment, size_t bytes) {
   Unreachable::CheckIfRequested(g_debug->config());
 
@@ -754,8 +769,8 @@ void* debug_memalign(size_t alignment, size_t bytes) {
     }
 
     if (g_debug->config().options() & RECORD_ALLOCS) {
-      g_debug->record->AddEntry(new MemalignEntry(pointer, bytes, alignment,
-                                                  result.GetStartTimeNS(), result.GetEndTimeNS()));
+      g_debug->record->AddEntry(MemalignEntry(pointer, bytes, alignment,
+                                              result.GetStartTimeNS(), result.GetEndTimeNS()));
     }
   }
 
@@ -775,8 +790,8 @@ void* debug_realloc(void* pointer, size_t bytes) {
   if (pointer == nullptr) {
     TimedResult result = InternalMalloc(bytes);
     if (g_debug->config().options() & RECORD_ALLOCS) {
-      g_debug->record->AddEntry(new ReallocEntry(result.getValue<void*>(), bytes, nullptr,
-                                                 result.GetStartTimeNS(), result.GetEndTimeNS()));
+      g_debug->record->AddEntry(ReallocEntry(result.getValue<void*>(), bytes, nullptr,
+                                             result.GetStartTimeNS(), result.GetEndTimeNS()));
     }
     pointer = result.getValue<void*>();
     return pointer;
@@ -787,11 +802,14 @@ void* debug_realloc(void* pointer, size_t bytes) {
   }
 
   if (bytes == 0) {
+    // Taken before the memory can be reused, see RecordData::NextSequence().
+    uint64_t sequence = RecordSequence();
     TimedResult result = InternalFree(pointer);
 
     if (g_debug->config().options() & RECORD_ALLOCS) {
-      g_debug->record->AddEntry(new ReallocEntry(nullptr, bytes, pointer, result.GetStartTimeNS(),
-                                                 result.GetEndTimeNS()));
+      g_debug->record->AddEntry(ReallocEntry(nullptr, bytes, pointer, result.GetStartTimeNS(),
+                                             result.GetEndTimeNS()),
+                                sequence);
     }
 
     return nullptr;
@@ -815,6 +833,7 @@ void* debug_realloc(void* pointer, size_t bytes) {
   TimedResult result;
   void* new_pointer;
   size_t prev_size;
+  uint64_t sequence;
   if (g_debug->HeaderEnabled()) {
     // Same size, do nothing.
     Header* header = g_debug->GetHeader(pointer);
@@ -855,6 +874,9 @@ void* debug_realloc(void* pointer, size_t bytes) {
 
     prev_size = header->usable_size;
     memcpy(new_pointer, pointer, prev_size);
+    // Between the allocation and the free, so this sorts after anything that
+    // released new_pointer, and before anything that reuses pointer.
+    sequence = RecordSequence();
     TimedResult free_time = InternalFree(pointer);
     // `realloc` is split into two steps, update the end time to the finish time
     // of the second operation.
@@ -874,6 +896,11 @@ void* debug_realloc(void* pointer, size_t bytes) {
     if (g_debug->TrackPointers()) {
       PointerData::Add(new_pointer, real_size);
     }
+    // The allocator frees the old pointer itself, so there's no point between
+    // the allocation and the free. Taking the sequence afterwards orders this
+    // after anything that released new_pointer, but a thread that reuses the
+    // old pointer straight away could still be ordered first.
+    sequence = RecordSequence();
   }
 
   if (g_debug->config().options() & FILL_ON_ALLOC) {
@@ -888,8 +915,9 @@ void* debug_realloc(void* pointer, size_t bytes) {
   }
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
-    g_debug->record->AddEntry(new ReallocEntry(new_pointer, bytes, pointer, result.GetStartTimeNS(),
-                                               result.GetEndTimeNS()));
+    g_debug->record->AddEntry(ReallocEntry(new_pointer, bytes, pointer, result.GetStartTimeNS(),
+                                           result.GetEndTimeNS()),
+                              sequence);
   }
 
   return new_pointer;
@@ -946,7 +974,7 @@ void* debug_calloc(size_t nmemb, size_t bytes) {
 
   if (g_debug->config().options() & RECORD_ALLOCS) {
     g_debug->record->AddEntry(
-        new CallocEntry(pointer, nmemb, bytes, result.GetStartTimeNS(), result.GetEndTimeNS()));
+        CallocEntry(pointer, nmemb, bytes, result.GetStartTimeNS(), result.GetEndTimeNS()));
   }
 
   if (pointer != nullptr && g_debug->TrackPointers()) {
@@ -1104,7 +1132,7 @@ void* debug_valloc(size_t size) {
 
 static std::mutex g_dump_lock;
 
-static void write_dump(int fd) {
+static bool write_dump(int fd) {
   dprintf(fd, "Android Native Heap Dump v1.2\n\n");
 
   std::string fingerprint = android::base::GetProperty("ro.build.fingerprint", "unknown");
@@ -1120,38 +1148,61 @@ static void write_dump(int fd) {
     dprintf(fd, "%s", content.c_str());
   }
   dprintf(fd, "END\n");
-
-  // Purge the memory that was allocated and freed during this operation
-  // since it can be large enough to expand the RSS significantly.
-  g_dispatch->mallopt(M_PURGE_ALL, 0);
+  return true;
 }
 
-bool debug_write_malloc_leak_info(FILE* fp) {
-  // Make sure any pending output is written to the file.
-  fflush(fp);
-
-  ScopedConcurrentLock lock;
-  ScopedDisableDebugCalls disable;
-  ScopedBacktraceSignalBlocker blocked;
-
-  std::lock_guard<std::mutex> guard(g_dump_lock);
-
-  if (!(g_debug->config().options() & BACKTRACE)) {
+// See the README for the layout of the binary dump. The stack table and the
+// allocation records are written by PointerData.
+static constexpr char kBinaryDumpMagic[8] = {'M', 'D', 'H', 'E', 'A', 'P', 'B', 'N'};
+static constexpr uint32_t kBinaryDumpVersion = 1;
+
+static bool write_binary_dump(int fd) {
+  std::string header(kBinaryDumpMagic, sizeof(kBinaryDumpMagic));
+  uint32_t value = kBinaryDumpVersion;
+  header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  value = sizeof(uintptr_t);
+  header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  std::string fingerprint = android::base::GetProperty("ro.build.fingerprint", "unknown");
+  value = fingerprint.size();
+  header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  header += fingerprint;
+  if (!android::base::WriteFully(fd, header.data(), header.size())) {
     return false;
   }
 
-  write_dump(fileno(fp));
+  if (!PointerData::DumpLiveToFileBinary(fd)) {
+    return false;
+  }
 
-  return true;
+  // The maps are stored as is, so that they can be matched up with the
+  // symbols offline.
+  std::string maps;
+  android::base::ReadFileToString("/proc/self/maps", &maps);
+  uint64_t maps_size = maps.size();
+  return android::base::WriteFully(fd, &maps_size, sizeof(maps_size)) &&
+         android::base::WriteFully(fd, maps.data(), maps.size());
 }
 
-void debug_dump_heap(const char* file_name) {
+// Runs one of the dump writers above with allocations and backtrace signals
+// held off.
+static bool locked_dump(int fd, bool (*write_fn)(int)) {
   ScopedConcurrentLock lock;
   ScopedDisableDebugCalls disable;
   ScopedBacktraceSignalBlocker blocked;
 
   std::lock_guard<std::mutex> guard(g_dump_lock);
 
+  bool result = write_fn(fd);
+
+  // Purge the memory that was allocated and freed during this operation
+  // since it can be large enough to expand the RSS significantly.
+  int saved_errno = errno;
+  g_dispatch->mallopt(M_PURGE_ALL, 0);
+  errno = saved_errno;
+  return result;
+}
+
+static void dump_heap_to_file(const char* file_name, bool (*write_fn)(int)) {
   int fd = open(file_name, O_RDWR | O_CREAT | O_NOFOLLOW | O_TRUNC | O_CLOEXEC, 0644);
   if (fd == -1) {
     error_log("Unable to create file: %s", file_name);
@@ -1159,6 +1210,39 @@ void debug_dump_heap(const char* file_name) {
   }
 
   error_log("Dumping to file: %s\n", file_name);
-  write_dump(fd);
+  if (!locked_dump(fd, write_fn)) {
+    error_log("Failed to write heap dump to %s: %s", file_name, strerror(errno));
+  }
   close(fd);
 }
+
+bool debug_write_malloc_leak_info(FILE* fp) {
+  if (!(g_debug->config().options() & BACKTRACE)) {
+    return false;
+  }
+
+  // Make sure any pending output is written to the file.
+  fflush(fp);
+
+  return locked_dump(fileno(fp), write_dump);
+}
+
+void debug_dump_heap(const char* file_name) {
+  dump_heap_to_file(file_name, write_dump);
+}
+
+static void DumpHeapWithPrefix(const char* suffix) {
+  const Config& config = g_debug->config();
+  if (config.backtrace_dump_binary()) {
+    dump_heap_to_file(android::base::StringPrintf("%s.%d%s.bin",
+                                                  config.backtrace_dump_prefix().c_str(), getpid(),
+                                                  suffix)
+                          .c_str(),
+                      write_binary_dump);
+  } else {
+    debug_dump_heap(android::base::StringPrintf("%s.%d%s.txt",
+                                                config.backtrace_dump_prefix().c_str(), getpid(),
+                                                suffix)
+                        .c_str());
+  }
+}
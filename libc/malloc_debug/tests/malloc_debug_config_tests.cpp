@@ -334,6 +334,29 @@ TEST_F(MallocDebugConfigTest, backtrace_dump_on_exit_error) {
   ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugConfigTest, backtrace_dump_binary) {
+  ASSERT_TRUE(InitConfig("backtrace_dump_binary")) << getFakeLogPrint();
+  ASSERT_EQ(0U, config->options());
+  ASSERT_TRUE(config->backtrace_dump_binary());
+
+  ASSERT_TRUE(InitConfig("bt_dmp_bin")) << getFakeLogPrint();
+  ASSERT_EQ(0U, config->options());
+  ASSERT_TRUE(config->backtrace_dump_binary());
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, backtrace_dump_binary_error) {
+  ASSERT_FALSE(InitConfig("backtrace_dump_binary=something")) << getFakeLogPrint();
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: value set for option 'backtrace_dump_binary' "
+      "which does not take a value\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugConfigTest, backtrace_dump_prefix) {
   ASSERT_TRUE(InitConfig("backtrace_dump_prefix")) << getFakeLogPrint();
   ASSERT_EQ(0U, config->options());
@@ -376,6 +399,27 @@ TEST_F(MallocDebugConfigTest, backtrace_full_fail) {
   ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugConfigTest, backtrace_fp) {
+  ASSERT_TRUE(InitConfig("backtrace_fp")) << getFakeLogPrint();
+  ASSERT_EQ(BACKTRACE_FP, config->options());
+
+  ASSERT_TRUE(InitConfig("bt_fp")) << getFakeLogPrint();
+  ASSERT_EQ(BACKTRACE_FP, config->options());
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugConfigTest, backtrace_fp_fail) {
+  ASSERT_FALSE(InitConfig("backtrace_fp=200")) << getFakeLogPrint();
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string log_msg(
+      "6 malloc_debug malloc_testing: value set for option 'backtrace_fp' "
+      "which does not take a value\n");
+  ASSERT_STREQ((log_msg + usage_string).c_str(), getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugConfigTest, fill_on_alloc) {
   ASSERT_TRUE(InitConfig("fill_on_alloc=64")) << getFakeLogPrint();
   ASSERT_EQ(FILL_ON_ALLOC, config->options());
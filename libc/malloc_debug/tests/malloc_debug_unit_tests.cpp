@@ -26,7 +26,12 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <string_view>
 #include <thread>
@@ -172,6 +177,10 @@ MallocDispatch MallocDebugTest::dispatch = {
   mallopt,
   aligned_alloc,
   malloc_info,
+  nullptr,
+  nullptr,
+  nullptr,
+  nullptr,
 };
 
 std::string ShowDiffs(uint8_t* a, uint8_t* b, size_t size) {
@@ -1102,6 +1111,33 @@ TEST_F(MallocDebugTest, free_track_multiple_thread) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, verify_pointers_multiple_thread) {
+  Init("verify_pointers");
+
+  std::vector<std::thread*> threads(100);
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i] = new std::thread([](){
+      void* pointers[50];
+      for (size_t j = 0; j < 100; j++) {
+        for (size_t k = 0; k < 50; k++) {
+          pointers[k] = debug_malloc(k + 1);
+        }
+        for (size_t k = 0; k < 50; k++) {
+          ASSERT_LE(k + 1, debug_malloc_usable_size(pointers[k]));
+          debug_free(pointers[k]);
+        }
+      }
+    });
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, free_track_pointer_modified_after_free) {
   Init("free_track=4 fill_on_free=2 free_track_backtrace_num_frames=0");
 
@@ -1361,6 +1397,48 @@ TEST_F(MallocDebugTest, get_malloc_backtrace_with_header) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, get_malloc_leak_info_backtrace_fp) {
+  Init("backtrace=16 backtrace_fp");
+
+  size_t individual_size = GetInfoEntrySize(16);
+  std::vector<uint8_t> expected_info(individual_size);
+  memset(expected_info.data(), 0, individual_size);
+
+  InfoEntry* entry = reinterpret_cast<InfoEntry*>(expected_info.data());
+  entry->size = 200;
+  entry->num_allocations = 1;
+  entry->frames[0] = 0xf;
+  entry->frames[1] = 0xe;
+  entry->frames[2] = 0xd;
+
+  backtrace_fake_add(std::vector<uintptr_t> {0xf, 0xe, 0xd});
+
+  void* pointer = debug_malloc(entry->size);
+  ASSERT_TRUE(pointer != nullptr);
+  memset(pointer, 0, entry->size);
+
+  uint8_t* info;
+  size_t overall_size;
+  size_t info_size;
+  size_t total_memory;
+  size_t backtrace_size;
+
+  debug_get_malloc_leak_info(&info, &overall_size, &info_size, &total_memory, &backtrace_size);
+  ASSERT_TRUE(info != nullptr);
+  ASSERT_EQ(individual_size, overall_size);
+  ASSERT_EQ(individual_size, info_size);
+  ASSERT_EQ(200U, total_memory);
+  ASSERT_EQ(16U, backtrace_size);
+  ASSERT_TRUE(memcmp(expected_info.data(), info, overall_size) == 0)
+      << ShowDiffs(expected_info.data(), info, overall_size);
+
+  debug_free_malloc_leak_info(info);
+  debug_free(pointer);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 static std::string SanitizeHeapData(const std::string& data) {
   if (data.empty()) {
     return data;
@@ -1483,6 +1561,101 @@ TEST_F(MallocDebugTest, backtrace_dump_on_signal_by_free) {
   BacktraceDumpOnSignal(false);
 }
 
+TEST_F(MallocDebugTest, backtrace_dump_binary_on_signal) {
+  Init("backtrace=4 backtrace_dump_binary");
+
+  backtrace_fake_add(std::vector<uintptr_t> {0x100, 0x200});
+  backtrace_fake_add(std::vector<uintptr_t> {0x100, 0x200});
+  backtrace_fake_add(std::vector<uintptr_t> {0xa000, 0xb000, 0xc000});
+
+  std::vector<void*> pointers;
+  pointers.push_back(debug_malloc(100));
+  pointers.push_back(debug_malloc(100));
+  pointers.push_back(debug_malloc(30));
+
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 17) == 0);
+  sleep(1);
+
+  // This triggers the dumping.
+  pointers.push_back(debug_malloc(23));
+  for (auto* pointer : pointers) {
+    debug_free(pointer);
+  }
+
+  std::string actual;
+  std::string name = android::base::StringPrintf("%s.%d.bin", BACKTRACE_DUMP_PREFIX, getpid());
+  ASSERT_TRUE(android::base::ReadFileToString(name, &actual));
+  ASSERT_EQ(0, unlink(name.c_str()));
+
+  // Header.
+  size_t offset = 0;
+  auto read = [&actual, &offset](auto* value) {
+    ASSERT_LE(offset + sizeof(*value), actual.size());
+    memcpy(value, &actual[offset], sizeof(*value));
+    offset += sizeof(*value);
+  };
+  ASSERT_EQ("MDHEAPBN", actual.substr(0, 8));
+  offset = 8;
+  uint32_t value32;
+  uint64_t value64;
+  read(&value32);
+  ASSERT_EQ(1U, value32);
+  read(&value32);
+  ASSERT_EQ(sizeof(uintptr_t), value32);
+  read(&value32);
+  offset += value32;
+  read(&value64);
+  ASSERT_EQ(230U, value64);
+  read(&value32);
+  ASSERT_EQ(4U, value32);
+
+  // Stack table: the two allocations from the same backtrace share a stack.
+  read(&value32);
+  ASSERT_EQ(2U, value32);
+  std::vector<std::vector<uint64_t>> stacks;
+  for (size_t i = 0; i < 2; i++) {
+    uint32_t num_frames;
+    read(&num_frames);
+    std::vector<uint64_t> frames(num_frames);
+    for (auto& frame : frames) {
+      read(&frame);
+    }
+    stacks.push_back(frames);
+  }
+
+  // Allocation records, in the same order as the text dump.
+  read(&value64);
+  ASSERT_EQ(2U, value64);
+  uint64_t size, num_allocations;
+  uint32_t stack, flags;
+  read(&size);
+  read(&num_allocations);
+  read(&stack);
+  read(&flags);
+  ASSERT_EQ(100U, size);
+  ASSERT_EQ(2U, num_allocations);
+  ASSERT_LT(stack, stacks.size());
+  ASSERT_EQ((std::vector<uint64_t>{0x100, 0x200}), stacks[stack]);
+  ASSERT_EQ(0U, flags);
+  read(&size);
+  read(&num_allocations);
+  read(&stack);
+  read(&flags);
+  ASSERT_EQ(30U, size);
+  ASSERT_EQ(1U, num_allocations);
+  ASSERT_LT(stack, stacks.size());
+  ASSERT_EQ((std::vector<uint64_t>{0xa000, 0xb000, 0xc000}), stacks[stack]);
+
+  // Maps, stored as text.
+  read(&value64);
+  ASSERT_EQ(actual.size(), offset + value64);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  std::string expected_log = android::base::StringPrintf(
+      "6 malloc_debug Dumping to file: /data/local/tmp/backtrace_heap.%d.bin\n\n", getpid());
+  ASSERT_STREQ(expected_log.c_str(), getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, backtrace_dump_on_exit) {
   pid_t pid;
   if ((pid = fork()) == 0) {
@@ -2338,6 +2511,122 @@ TEST_F(MallocDebugTest, record_allocs_thread_done) {
   ASSERT_STREQ("", getFakeLogPrint().c_str());
 }
 
+TEST_F(MallocDebugTest, record_allocs_multiple_threads) {
+  InitRecordAllocs("record_allocs");
+
+  // Enough allocations per thread that each thread's buffered records
+  // have to be moved to the shared records several times.
+  constexpr size_t kNumThreads = 20;
+  constexpr size_t kNumAllocs = 1000;
+  std::vector<std::thread*> threads(kNumThreads);
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i] = new std::thread([](){
+      for (size_t j = 0; j < kNumAllocs; j++) {
+        void* pointer = debug_malloc(j + 1);
+        write(0, pointer, 0);
+        debug_free(pointer);
+      }
+    });
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  // Dump all of the data accumulated so far.
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 18) == 0);
+
+  std::string actual;
+  ASSERT_TRUE(android::base::ReadFileToString(record_filename, &actual));
+
+  std::map<std::string, size_t> counts;
+  for (const auto& line : android::base::Split(android::base::Trim(actual), "\n")) {
+    std::vector<std::string> fields = android::base::Split(line, " ");
+    ASSERT_LE(2U, fields.size()) << line;
+    counts[fields[1]]++;
+  }
+  EXPECT_EQ(kNumThreads * kNumAllocs, counts["malloc"]);
+  EXPECT_EQ(kNumThreads * kNumAllocs, counts["free"]);
+  EXPECT_EQ(kNumThreads, counts["thread_done"]);
+  EXPECT_EQ(3U, counts.size());
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
+TEST_F(MallocDebugTest, record_allocs_cross_thread_order) {
+  InitRecordAllocs("record_allocs");
+
+  // Pointers allocated on one thread are reallocated and freed on another,
+  // so the dump is only replayable if it's in call order across threads.
+  // The reallocs don't change the size class, and the frees wait until the
+  // allocating is done, so that no address is reused while both threads run.
+  constexpr size_t kNumAllocs = 2000;
+  std::mutex lock;
+  std::condition_variable cv;
+  std::deque<void*> queue;
+  bool done = false;
+  std::thread producer([&]() {
+    for (size_t i = 0; i < kNumAllocs; i++) {
+      void* pointer = debug_malloc(32);
+      ASSERT_TRUE(pointer != nullptr);
+      std::lock_guard<std::mutex> guard(lock);
+      queue.push_back(pointer);
+      cv.notify_one();
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    done = true;
+    cv.notify_one();
+  });
+  std::thread consumer([&]() {
+    std::vector<void*> pointers;
+    while (true) {
+      std::unique_lock<std::mutex> guard(lock);
+      cv.wait(guard, [&]() { return done || !queue.empty(); });
+      if (queue.empty()) break;
+      void* pointer = queue.front();
+      queue.pop_front();
+      guard.unlock();
+      pointer = debug_realloc(pointer, 30);
+      ASSERT_TRUE(pointer != nullptr);
+      pointers.push_back(pointer);
+    }
+    for (void* pointer : pointers) debug_free(pointer);
+  });
+  producer.join();
+  consumer.join();
+
+  // Dump all of the data accumulated so far.
+  ASSERT_TRUE(kill(getpid(), SIGRTMAX - 18) == 0);
+
+  std::string actual;
+  ASSERT_TRUE(android::base::ReadFileToString(record_filename, &actual));
+
+  // Replay the pointers: each must be live when it's reallocated or freed.
+  std::set<std::string> live;
+  size_t num_records = 0;
+  for (const auto& line : android::base::Split(android::base::Trim(actual), "\n")) {
+    std::vector<std::string> fields = android::base::Split(line, " ");
+    ASSERT_LE(3U, fields.size()) << line;
+    if (fields[1] == "malloc") {
+      ASSERT_TRUE(live.insert(fields[2]).second) << line;
+    } else if (fields[1] == "realloc") {
+      ASSERT_LE(4U, fields.size()) << line;
+      ASSERT_EQ(1U, live.erase(fields[3])) << "realloc before its allocation: " << line;
+      ASSERT_TRUE(live.insert(fields[2]).second) << line;
+    } else if (fields[1] == "free") {
+      ASSERT_EQ(1U, live.erase(fields[2])) << "free before its allocation: " << line;
+    }
+    num_records++;
+  }
+  EXPECT_TRUE(live.empty());
+  // Every allocation is malloc'ed, realloc'ed and freed, plus two thread_dones.
+  EXPECT_EQ(3 * kNumAllocs + 2, num_records);
+
+  ASSERT_STREQ("", getFakeLogBuf().c_str());
+  ASSERT_STREQ("", getFakeLogPrint().c_str());
+}
+
 TEST_F(MallocDebugTest, record_allocs_file_name_fail) {
   InitRecordAllocs("record_allocs=5");
 
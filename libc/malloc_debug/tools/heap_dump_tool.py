@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2023 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Reads a binary heap dump written by malloc debug (backtrace_dump_binary).
+
+By default, prints the backtraces holding the most memory, symbolized using
+the unstripped libraries found under --symbols. With --text, converts the
+dump to the "Android Native Heap Dump v1.2" text format instead, so that the
+existing heap dump tools can read it.
+"""
+
+import argparse
+import bisect
+import collections
+import os
+import shutil
+import struct
+import subprocess
+import sys
+
+MAGIC = b"MDHEAPBN"
+VERSION = 1
+NO_STACK = 0xffffffff
+ZYGOTE_CHILD = 0x1
+
+Record = collections.namedtuple("Record", "size num_allocations stack zygote_child")
+Map = collections.namedtuple("Map", "start end offset name")
+
+
+class DumpError(Exception):
+  pass
+
+
+class Reader:
+  def __init__(self, data):
+    self.data = data
+    self.offset = 0
+
+  def read(self, fmt):
+    size = struct.calcsize(fmt)
+    if self.offset + size > len(self.data):
+      raise DumpError("truncated dump at offset %d" % self.offset)
+    values = struct.unpack_from(fmt, self.data, self.offset)
+    self.offset += size
+    return values
+
+  def read_bytes(self, size):
+    if self.offset + size > len(self.data):
+      raise DumpError("truncated dump at offset %d" % self.offset)
+    value = self.data[self.offset:self.offset + size]
+    self.offset += size
+    return value
+
+
+class HeapDump:
+  def __init__(self, data):
+    reader = Reader(data)
+    magic = reader.read_bytes(len(MAGIC))
+    if magic != MAGIC:
+      raise DumpError("not a malloc debug binary heap dump")
+    version, self.pointer_size = reader.read("<II")
+    if version != VERSION:
+      raise DumpError("unsupported dump version %d" % version)
+    (fingerprint_size,) = reader.read("<I")
+    self.fingerprint = reader.read_bytes(fingerprint_size).decode(errors="replace")
+    self.total_memory, self.backtrace_size = reader.read("<QI")
+
+    (num_stacks,) = reader.read("<I")
+    self.stacks = []
+    for _ in range(num_stacks):
+      (num_frames,) = reader.read("<I")
+      self.stacks.append(reader.read("<%dQ" % num_frames))
+
+    (num_records,) = reader.read("<Q")
+    self.records = []
+    for _ in range(num_records):
+      size, num_allocations, stack, flags = reader.read("<QQII")
+      self.records.append(Record(size, num_allocations,
+                                 None if stack == NO_STACK else stack,
+                                 bool(flags & ZYGOTE_CHILD)))
+
+    (maps_size,) = reader.read("<Q")
+    self.maps_text = reader.read_bytes(maps_size).decode(errors="replace")
+    self.maps = parse_maps(self.maps_text)
+    self.map_starts = [m.start for m in self.maps]
+
+  def find_map(self, pc):
+    index = bisect.bisect_right(self.map_starts, pc) - 1
+    if index >= 0 and pc < self.maps[index].end:
+      return self.maps[index]
+    return None
+
+
+def parse_maps(text):
+  maps = []
+  for line in text.splitlines():
+    fields = line.split(None, 5)
+    if len(fields) < 5:
+      continue
+    start, end = (int(x, 16) for x in fields[0].split("-"))
+    name = fields[5] if len(fields) == 6 else ""
+    maps.append(Map(start, end, int(fields[2], 16), name))
+  maps.sort(key=lambda m: m.start)
+  return maps
+
+
+class Symbolizer:
+  """Symbolizes frames one library at a time with llvm-symbolizer."""
+
+  def __init__(self, symbols_dir, symbolizer):
+    self.symbols_dir = symbols_dir
+    self.symbolizer = symbolizer
+    self.cache = {}
+
+  def symbolize(self, dump, pcs):
+    by_library = collections.defaultdict(set)
+    for pc in pcs:
+      m = dump.find_map(pc)
+      if m is not None and m.name.startswith("/"):
+        by_library[m.name].add(pc - m.start + m.offset)
+    for name, rel_pcs in by_library.items():
+      self._symbolize_library(name, sorted(rel_pcs))
+
+  def _symbolize_library(self, name, rel_pcs):
+    path = os.path.join(self.symbols_dir, name.lstrip("/")) if self.symbols_dir else None
+    if not path or not self.symbolizer or not os.path.exists(path):
+      return
+    # The mapped offset is used as the address, which is right for libraries
+    # whose executable segment has matching file and virtual addresses.
+    result = subprocess.run([self.symbolizer, "--obj=" + path, "--demangle", "--functions=linkage"],
+                            input="\n".join("0x%x" % pc for pc in rel_pcs) + "\n",
+                            capture_output=True, text=True, check=False)
+    lines = result.stdout.split("\n\n")
+    for rel_pc, block in zip(rel_pcs, lines):
+      block_lines = block.strip().splitlines()
+      if block_lines and block_lines[0] != "??":
+        self.cache[(name, rel_pc)] = block_lines[0]
+
+  def describe(self, dump, pc):
+    m = dump.find_map(pc)
+    if m is None:
+      return "%016x  <unknown>" % pc
+    rel_pc = pc - m.start + m.offset
+    function = self.cache.get((m.name, rel_pc))
+    if function:
+      return "%016x  %s (%s)" % (rel_pc, m.name, function)
+    return "%016x  %s" % (rel_pc, m.name)
+
+
+def write_text(dump, out):
+  out.write("Android Native Heap Dump v1.2\n\n")
+  out.write("Build fingerprint: '%s'\n\n" % dump.fingerprint)
+  out.write("Total memory: %d\n" % dump.total_memory)
+  out.write("Allocation records: %d\n" % len(dump.records))
+  out.write("Backtrace size: %d\n\n" % dump.backtrace_size)
+  for record in dump.records:
+    out.write("z %d  sz %8d  num    %d  bt" % (1 if record.zygote_child else 0, record.size,
+                                              record.num_allocations))
+    if record.stack is not None:
+      for frame in dump.stacks[record.stack]:
+        if frame == 0:
+          break
+        out.write(" %x" % frame)
+    out.write("\n")
+  out.write("MAPS\n")
+  out.write(dump.maps_text)
+  out.write("END\n")
+
+
+def write_report(dump, symbolizer, top, out):
+  by_stack = collections.defaultdict(lambda: [0, 0])
+  for record in dump.records:
+    totals = by_stack[record.stack]
+    totals[0] += record.size * record.num_allocations
+    totals[1] += record.num_allocations
+  ordered = sorted(by_stack.items(), key=lambda item: item[1][0], reverse=True)[:top]
+
+  pcs = set()
+  for stack, _ in ordered:
+    if stack is not None:
+      pcs.update(dump.stacks[stack])
+  symbolizer.symbolize(dump, pcs)
+
+  out.write("Build fingerprint: '%s'\n" % dump.fingerprint)
+  out.write("Total memory: %d bytes in %d unique backtraces\n\n" % (dump.total_memory,
+                                                                    len(by_stack)))
+  for stack, (total, count) in ordered:
+    percent = 100.0 * total / dump.total_memory if dump.total_memory else 0
+    out.write("%d bytes (%.2f%%) in %d allocations\n" % (total, percent, count))
+    if stack is None:
+      out.write("  <no backtrace>\n")
+    else:
+      for i, pc in enumerate(dump.stacks[stack]):
+        out.write("  #%02d  %s\n" % (i, symbolizer.describe(dump, pc)))
+    out.write("\n")
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+                                   formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument("dump", help="binary heap dump file")
+  parser.add_argument("--symbols", help="directory containing the unstripped libraries")
+  parser.add_argument("--symbolizer", default=shutil.which("llvm-symbolizer"),
+                      help="path to llvm-symbolizer")
+  parser.add_argument("--top", type=int, default=50,
+                      help="number of backtraces to report (default 50)")
+  parser.add_argument("--text", action="store_true",
+                      help="convert to the native heap dump text format")
+  args = parser.parse_args()
+
+  with open(args.dump, "rb") as f:
+    data = f.read()
+  try:
+    dump = HeapDump(data)
+  except DumpError as e:
+    sys.exit("%s: %s" % (args.dump, e))
+
+  if args.text:
+    write_text(dump, sys.stdout)
+  else:
+    write_report(dump, Symbolizer(args.symbols, args.symbolizer), args.top, sys.stdout)
+
+
+if __name__ == "__main__":
+  main()
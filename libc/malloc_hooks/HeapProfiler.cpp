@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include <async_safe/log.h>
+#include <platform/bionic/android_unsafe_frame_pointer_chase.h>
+
+#include "HeapProfiler.h"
+
+#define error_log(format, ...) \
+  async_safe_format_log(ANDROID_LOG_ERROR, "malloc_hooks", (format), ##__VA_ARGS__)
+
+bool g_heap_profiler_enabled;
+thread_local int64_t g_heap_profiler_bytes_until_sample;
+std::atomic_bool g_heap_profiler_dump_requested;
+std::atomic_uint16_t g_heap_profiler_filter[kHeapProfilerFilterSize];
+
+static constexpr char kSampleIntervalEnv[] = "LIBC_HOOKS_HEAP_PROFILE";
+static constexpr char kFilePrefixEnv[] = "LIBC_HOOKS_HEAP_PROFILE_FILE";
+static constexpr char kDefaultFilePrefix[] = "/data/local/tmp/heap_profile";
+
+// The same signal malloc debug uses to dump the heap, the two are never
+// enabled together.
+static const int kDumpSignal = SIGRTMAX - 17;
+
+static constexpr size_t kMaxFrames = 64;
+// HeapProfilerSample itself and the hooks_* function that called it.
+static constexpr size_t kProfilerFrames = 2;
+
+struct Stack {
+  size_t num_frames;
+  uintptr_t frames[kMaxFrames];
+
+  bool operator==(const Stack& other) const {
+    return num_frames == other.num_frames &&
+           memcmp(frames, other.frames, num_frames * sizeof(uintptr_t)) == 0;
+  }
+};
+
+struct StackHash {
+  size_t operator()(const Stack& stack) const {
+    size_t hash = stack.num_frames;
+    for (size_t i = 0; i < stack.num_frames; i++) {
+      hash = hash * 31 + stack.frames[i];
+    }
+    return hash;
+  }
+};
+
+struct Bucket {
+  size_t live_count = 0;
+  size_t live_bytes = 0;
+  size_t total_count = 0;
+  size_t total_bytes = 0;
+};
+
+struct Sample {
+  size_t size;
+  Bucket* bucket;
+};
+
+static size_t g_sample_interval;
+static std::string* g_file_prefix;
+
+// Protects g_buckets and g_samples. Sampled allocations are rare, so a
+// single lock is enough.
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::unordered_map<Stack, Bucket, StackHash>* g_buckets;
+static std::unordered_map<uintptr_t, Sample>* g_samples;
+
+// Set while this thread is inside the profiler, so that the allocations
+// made by the containers above are neither sampled nor looked up.
+static thread_local bool g_in_profiler;
+static thread_local uint64_t g_random_state;
+
+class ScopedProfilerLock {
+ public:
+  ScopedProfilerLock() {
+    pthread_mutex_lock(&g_lock);
+    g_in_profiler = true;
+  }
+  ~ScopedProfilerLock() {
+    g_in_profiler = false;
+    pthread_mutex_unlock(&g_lock);
+  }
+};
+
+static uint64_t NextRandom() {
+  if (g_random_state == 0) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    g_random_state = (static_cast<uint64_t>(gettid()) << 32) ^ ts.tv_nsec ^
+                     reinterpret_cast<uintptr_t>(&g_random_state);
+    if (g_random_state == 0) {
+      g_random_state = 1;
+    }
+  }
+  // xorshift64*
+  g_random_state ^= g_random_state >> 12;
+  g_random_state ^= g_random_state << 25;
+  g_random_state ^= g_random_state >> 27;
+  return g_random_state * 0x2545f4914f6cdd1dULL;
+}
+
+// Returns -ln(u) for u uniformly distributed in (0, 1]. This library cannot
+// depend on libm, so the log is computed from the exponent plus a short
+// series for the mantissa, which is accurate to better than 1e-5.
+static double NegativeLogUniform() {
+  uint64_t q = (NextRandom() >> 11) + 1;
+  int exponent = 63 - __builtin_clzll(q);
+  double m = static_cast<double>(q) / static_cast<double>(1ULL << exponent);
+  double t = (m - 1) / (m + 1);
+  double t2 = t * t;
+  double log_m = 2 * t * (1 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 / 9))));
+  constexpr double kLog2 = 0.69314718055994530942;
+  return (53 - exponent) * kLog2 - log_m;
+}
+
+// The gap to the next sample is exponentially distributed, which makes the
+// sampled bytes a Poisson process with the configured mean.
+static int64_t NextSampleInterval() {
+  return static_cast<int64_t>(NegativeLogUniform() * g_sample_interval) + 1;
+}
+
+static void EnableDump(int, siginfo_t*, void*) {
+  g_heap_profiler_dump_requested = true;
+}
+
+static void InitAtfork() {
+  pthread_atfork([]() { pthread_mutex_lock(&g_lock); },
+                 []() { pthread_mutex_unlock(&g_lock); },
+                 []() { pthread_mutex_init(&g_lock, nullptr); });
+}
+
+bool HeapProfilerInitialize() {
+  const char* interval = getenv(kSampleIntervalEnv);
+  if (interval == nullptr || *interval == '\0') {
+    return true;
+  }
+  char* end;
+  errno = 0;
+  unsigned long long value = strtoull(interval, &end, 10);
+  if (errno != 0 || *end != '\0' || value == 0 || value > INT32_MAX) {
+    error_log("%s: bad value for %s: '%s', heap profiling disabled", getprogname(),
+              kSampleIntervalEnv, interval);
+    return true;
+  }
+  g_sample_interval = value;
+
+  const char* prefix = getenv(kFilePrefixEnv);
+  if (prefix == nullptr || *prefix == '\0') {
+    prefix = kDefaultFilePrefix;
+  }
+  g_file_prefix = new std::string(prefix);
+  g_buckets = new std::unordered_map<Stack, Bucket, StackHash>;
+  g_samples = new std::unordered_map<uintptr_t, Sample>;
+
+  struct sigaction64 act = {};
+  act.sa_sigaction = EnableDump;
+  act.sa_flags = SA_RESTART | SA_SIGINFO | SA_ONSTACK;
+  if (sigaction64(kDumpSignal, &act, nullptr) != 0) {
+    error_log("Unable to set up heap profile dump signal function: %s", strerror(errno));
+    return false;
+  }
+  InitAtfork();
+
+  g_heap_profiler_enabled = true;
+  return true;
+}
+
+__attribute__((noinline)) void HeapProfilerSample(void* pointer, size_t size) {
+  if (g_in_profiler) {
+    // Don't sample the profiler's own allocations, but start a new interval
+    // anyway: otherwise the count stays at or below zero, and every later
+    // allocation on this thread takes the slow path until one is sampled.
+    g_heap_profiler_bytes_until_sample = NextSampleInterval();
+    return;
+  }
+  if (g_random_state == 0) {
+    // This thread has not drawn an interval yet, so the count down started
+    // at zero rather than at a random point.
+    g_heap_profiler_bytes_until_sample += NextSampleInterval();
+    if (g_heap_profiler_bytes_until_sample > 0) {
+      return;
+    }
+  }
+  g_heap_profiler_bytes_until_sample = NextSampleInterval();
+
+  uintptr_t frames[kProfilerFrames + kMaxFrames];
+  size_t num_frames = android_unsafe_frame_pointer_chase(frames, kProfilerFrames + kMaxFrames);
+  num_frames = std::min(num_frames, kProfilerFrames + kMaxFrames);
+
+  Stack stack;
+  stack.num_frames = num_frames > kProfilerFrames ? num_frames - kProfilerFrames : 0;
+  memcpy(stack.frames, &frames[kProfilerFrames], stack.num_frames * sizeof(uintptr_t));
+
+  ScopedProfilerLock lock;
+  Bucket* bucket = &(*g_buckets)[stack];
+  bucket->live_count++;
+  bucket->live_bytes += size;
+  bucket->total_count++;
+  bucket->total_bytes += size;
+
+  auto [entry, inserted] = g_samples->try_emplace(reinterpret_cast<uintptr_t>(pointer),
+                                                  Sample{size, bucket});
+  if (inserted) {
+    g_heap_profiler_filter[HeapProfilerFilterIndex(pointer)]++;
+  } else {
+    // The free of the previous allocation at this address was missed.
+    entry->second.bucket->live_count--;
+    entry->second.bucket->live_bytes -= entry->second.size;
+    entry->second = Sample{size, bucket};
+  }
+}
+
+void HeapProfilerFree(void* pointer) {
+  if (g_in_profiler) {
+    return;
+  }
+  ScopedProfilerLock lock;
+  auto entry = g_samples->find(reinterpret_cast<uintptr_t>(pointer));
+  if (entry == g_samples->end()) {
+    return;
+  }
+  entry->second.bucket->live_count--;
+  entry->second.bucket->live_bytes -= entry->second.size;
+  g_samples->erase(entry);
+  g_heap_profiler_filter[HeapProfilerFilterIndex(pointer)]--;
+}
+
+class ProfileWriter {
+ public:
+  explicit ProfileWriter(int fd) : fd_(fd) {}
+  ~ProfileWriter() { Flush(); }
+
+  void Append(const char* format, ...) __printflike(2, 3) {
+    if (sizeof(buffer_) - length_ < kMaxAppend) {
+      Flush();
+    }
+    va_list args;
+    va_start(args, format);
+    size_t available = sizeof(buffer_) - length_;
+    int written = async_safe_format_buffer_va_list(&buffer_[length_], available, format, args);
+    va_end(args);
+    length_ += std::min(static_cast<size_t>(written), available - 1);
+  }
+
+  void AppendFile(const char* path) {
+    Flush();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      return;
+    }
+    ssize_t bytes;
+    while ((bytes = TEMP_FAILURE_RETRY(read(fd, buffer_, sizeof(buffer_)))) > 0) {
+      length_ = bytes;
+      Flush();
+    }
+    close(fd);
+  }
+
+  void Flush() {
+    size_t offset = 0;
+    while (offset < length_) {
+      ssize_t bytes = TEMP_FAILURE_RETRY(write(fd_, &buffer_[offset], length_ - offset));
+      if (bytes <= 0) {
+        break;
+      }
+      offset += bytes;
+    }
+    length_ = 0;
+  }
+
+ private:
+  // Every Append is a header or a single frame, well under this size.
+  static constexpr size_t kMaxAppend = 128;
+
+  int fd_;
+  char buffer_[4096];
+  size_t length_ = 0;
+};
+
+// Writes the samples in the legacy heap profile format, which pprof reads
+// directly and symbolizes using the maps that follow the samples:
+//   heap profile: <live count>: <live bytes> [<total count>: <total bytes>] @ heap_v2/<interval>
+//   <live count>: <live bytes> [<total count>: <total bytes>] @ <pc> <pc> ...
+//   ...
+//   MAPPED_LIBRARIES:
+//   <contents of /proc/self/maps>
+static void WriteProfile(const char* suffix) {
+  if (g_in_profiler) {
+    return;
+  }
+  ScopedProfilerLock lock;
+
+  char path[PATH_MAX];
+  async_safe_format_buffer(path, sizeof(path), "%s.%d%s.heap", g_file_prefix->c_str(), getpid(),
+                           suffix);
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1) {
+    error_log("Unable to create heap profile file %s: %s", path, strerror(errno));
+    return;
+  }
+
+  Bucket totals;
+  for (const auto& [stack, bucket] : *g_buckets) {
+    totals.live_count += bucket.live_count;
+    totals.live_bytes += bucket.live_bytes;
+    totals.total_count += bucket.total_count;
+    totals.total_bytes += bucket.total_bytes;
+  }
+
+  {
+    ProfileWriter writer(fd);
+    writer.Append("heap profile: %6zu: %8zu [%6zu: %8zu] @ heap_v2/%zu\n", totals.live_count,
+                  totals.live_bytes, totals.total_count, totals.total_bytes, g_sample_interval);
+    for (const auto& [stack, bucket] : *g_buckets) {
+      writer.Append("%6zu: %8zu [%6zu: %8zu] @", bucket.live_count, bucket.live_bytes,
+                    bucket.total_count, bucket.total_bytes);
+      for (size_t i = 0; i < stack.num_frames; i++) {
+        writer.Append(" 0x%" PRIxPTR, stack.frames[i]);
+      }
+      writer.Append("\n");
+    }
+    writer.Append("\nMAPPED_LIBRARIES:\n");
+    writer.AppendFile("/proc/self/maps");
+  }
+  close(fd);
+}
+
+void HeapProfilerDumpAndReset() {
+  bool expected = true;
+  if (g_heap_profiler_dump_requested.compare_exchange_strong(expected, false)) {
+    WriteProfile("");
+  }
+}
+
+void HeapProfilerFinalize() {
+  if (g_heap_profiler_enabled) {
+    WriteProfile(".exit");
+  }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+#include <atomic>
+
+// A Poisson sampling heap profiler, enabled by setting the environment
+// variable LIBC_HOOKS_HEAP_PROFILE to the mean number of bytes between
+// samples. Each thread counts down the bytes it allocates, and records the
+// frame pointer stack of the allocation that takes the count to zero. The
+// live samples are written out in the legacy heap profile format that pprof
+// reads, either when the dump signal is received or at exit.
+
+// Set once in HeapProfilerInitialize, before any allocation is intercepted.
+extern bool g_heap_profiler_enabled;
+
+// The number of bytes this thread can allocate before the next sample. It
+// starts at zero so the first allocation on a thread draws an interval.
+extern thread_local int64_t g_heap_profiler_bytes_until_sample;
+
+extern std::atomic_bool g_heap_profiler_dump_requested;
+
+// Counts of the live samples in each bucket of the pointer hash, so that a
+// free can skip the lock unless the pointer might have been sampled.
+constexpr size_t kHeapProfilerFilterSize = 1 << 16;
+extern std::atomic_uint16_t g_heap_profiler_filter[kHeapProfilerFilterSize];
+
+static inline size_t HeapProfilerFilterIndex(void* pointer) {
+  uintptr_t value = reinterpret_cast<uintptr_t>(pointer) >> 4;
+  return (value ^ (value >> 16)) % kHeapProfilerFilterSize;
+}
+
+bool HeapProfilerInitialize();
+void HeapProfilerFinalize();
+
+// Slow paths, only called from the inline functions below.
+void HeapProfilerSample(void* pointer, size_t size);
+void HeapProfilerFree(void* pointer);
+void HeapProfilerDumpAndReset();
+
+static inline void HeapProfilerRecordAlloc(void* pointer, size_t size) {
+  if (__predict_true(!g_heap_profiler_enabled) || pointer == nullptr) {
+    return;
+  }
+  if (__predict_false(g_heap_profiler_dump_requested.load(std::memory_order_relaxed))) {
+    HeapProfilerDumpAndReset();
+  }
+  g_heap_profiler_bytes_until_sample -= static_cast<int64_t>(size);
+  if (__predict_false(g_heap_profiler_bytes_until_sample <= 0)) {
+    HeapProfilerSample(pointer, size);
+  }
+}
+
+// Must be called before the pointer is released, so that a new allocation
+// at the same address cannot be confused with the sampled one.
+static inline void HeapProfilerRecordFree(void* pointer) {
+  if (__predict_true(!g_heap_profiler_enabled) || pointer == nullptr) {
+    return;
+  }
+  if (__predict_false(g_heap_profiler_filter[HeapProfilerFilterIndex(pointer)].load(
+                          std::memory_order_relaxed) != 0)) {
+    HeapProfilerFree(pointer);
+  }
+}
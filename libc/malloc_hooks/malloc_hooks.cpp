@@ -36,6 +36,8 @@
 
 #include <private/bionic_malloc_dispatch.h>
 
+#include "HeapProfiler.h"
+
 // ------------------------------------------------------------------------
 // Global Data
 // ------------------------------------------------------------------------
@@ -60,6 +62,8 @@ size_t hooks_malloc_usable_size(void* pointer);
 void* hooks_malloc(size_t size);
 int hooks_malloc_info(int options, FILE* fp);
 void hooks_free(void* pointer);
+void hooks_free_sized(void* pointer, size_t bytes);
+void hooks_free_aligned_sized(void* pointer, size_t alignment, size_t bytes);
 void* hooks_memalign(size_t alignment, size_t bytes);
 void* hooks_aligned_alloc(size_t alignment, size_t bytes);
 void* hooks_realloc(void* pointer, size_t bytes);
@@ -79,19 +83,27 @@ void* hooks_valloc(size_t size);
 #endif
 
 static void* default_malloc_hook(size_t bytes, const void*) {
-  return g_dispatch->malloc(bytes);
+  void* ptr = g_dispatch->malloc(bytes);
+  HeapProfilerRecordAlloc(ptr, bytes);
+  return ptr;
 }
 
 static void* default_realloc_hook(void* pointer, size_t bytes, const void*) {
-  return g_dispatch->realloc(pointer, bytes);
+  HeapProfilerRecordFree(pointer);
+  void* ptr = g_dispatch->realloc(pointer, bytes);
+  HeapProfilerRecordAlloc(ptr, bytes);
+  return ptr;
 }
 
 static void default_free_hook(void* pointer, const void*) {
+  HeapProfilerRecordFree(pointer);
   g_dispatch->free(pointer);
 }
 
 static void* default_memalign_hook(size_t alignment, size_t bytes, const void*) {
-  return g_dispatch->memalign(alignment, bytes);
+  void* ptr = g_dispatch->memalign(alignment, bytes);
+  HeapProfilerRecordAlloc(ptr, bytes);
+  return ptr;
 }
 
 __END_DECLS
@@ -103,10 +115,11 @@ bool hooks_initialize(const MallocDispatch* malloc_dispatch, bool*, const char*)
   __realloc_hook = default_realloc_hook;
   __free_hook = default_free_hook;
   __memalign_hook = default_memalign_hook;
-  return true;
+  return HeapProfilerInitialize();
 }
 
 void hooks_finalize() {
+  HeapProfilerFinalize();
 }
 
 void hooks_get_malloc_leak_info(uint8_t** info, size_t* overall_size,
@@ -129,28 +142,61 @@ void* hooks_malloc(size_t size) {
   if (__malloc_hook != nullptr && __malloc_hook != default_malloc_hook) {
     return __malloc_hook(size, __builtin_return_address(0));
   }
-  return g_dispatch->malloc(size);
+  void* ptr = g_dispatch->malloc(size);
+  HeapProfilerRecordAlloc(ptr, size);
+  return ptr;
 }
 
 void hooks_free(void* pointer) {
   if (__free_hook != nullptr && __free_hook != default_free_hook) {
     return __free_hook(pointer, __builtin_return_address(0));
   }
-  return g_dispatch->free(pointer);
+  HeapProfilerRecordFree(pointer);
+  g_dispatch->free(pointer);
+}
+
+void hooks_free_sized(void* pointer, size_t bytes) {
+  if (__free_hook != nullptr && __free_hook != default_free_hook) {
+    return __free_hook(pointer, __builtin_return_address(0));
+  }
+  HeapProfilerRecordFree(pointer);
+  if (g_dispatch->free_sized != nullptr) {
+    g_dispatch->free_sized(pointer, bytes);
+  } else {
+    g_dispatch->free(pointer);
+  }
+}
+
+void hooks_free_aligned_sized(void* pointer, size_t alignment, size_t bytes) {
+  if (__free_hook != nullptr && __free_hook != default_free_hook) {
+    return __free_hook(pointer, __builtin_return_address(0));
+  }
+  HeapProfilerRecordFree(pointer);
+  if (g_dispatch->free_aligned_sized != nullptr) {
+    g_dispatch->free_aligned_sized(pointer, alignment, bytes);
+  } else {
+    g_dispatch->free(pointer);
+  }
 }
 
 void* hooks_memalign(size_t alignment, size_t bytes) {
   if (__memalign_hook != nullptr && __memalign_hook != default_memalign_hook) {
     return __memalign_hook(alignment, bytes, __builtin_return_address(0));
   }
-  return g_dispatch->memalign(alignment, bytes);
+  void* ptr = g_dispatch->memalign(alignment, bytes);
+  HeapProfilerRecordAlloc(ptr, bytes);
+  return ptr;
 }
 
 void* hooks_realloc(void* pointer, size_t bytes) {
   if (__realloc_hook != nullptr && __realloc_hook != default_realloc_hook) {
     return __realloc_hook(pointer, bytes, __builtin_return_address(0));
   }
-  return g_dispatch->realloc(pointer, bytes);
+  // If the realloc fails, the sample for the original pointer is lost.
+  HeapProfilerRecordFree(pointer);
+  void* ptr = g_dispatch->realloc(pointer, bytes);
+  HeapProfilerRecordAlloc(ptr, bytes);
+  return ptr;
 }
 
 void* hooks_calloc(size_t nmemb, size_t bytes) {
@@ -165,7 +211,11 @@ void* hooks_calloc(size_t nmemb, size_t bytes) {
     }
     return ptr;
   }
-  return g_dispatch->calloc(nmemb, bytes);
+  void* ptr = g_dispatch->calloc(nmemb, bytes);
+  if (ptr != nullptr) {
+    HeapProfilerRecordAlloc(ptr, nmemb * bytes);
+  }
+  return ptr;
 }
 
 struct mallinfo hooks_mallinfo() {
@@ -192,7 +242,9 @@ void* hooks_aligned_alloc(size_t alignment, size_t size) {
     }
     return ptr;
   }
-  return g_dispatch->aligned_alloc(alignment, size);
+  void* ptr = g_dispatch->aligned_alloc(alignment, size);
+  HeapProfilerRecordAlloc(ptr, size);
+  return ptr;
 }
 
 int hooks_posix_memalign(void** memptr, size_t alignment, size_t size) {
@@ -206,7 +258,11 @@ int hooks_posix_memalign(void** memptr, size_t alignment, size_t size) {
     }
     return 0;
   }
-  return g_dispatch->posix_memalign(memptr, alignment, size);
+  int ret = g_dispatch->posix_memalign(memptr, alignment, size);
+  if (ret == 0) {
+    HeapProfilerRecordAlloc(*memptr, size);
+  }
+  return ret;
 }
 
 int hooks_malloc_iterate(uintptr_t, size_t, void (*)(uintptr_t, size_t, void*), void*) {
@@ -26,8 +26,10 @@
  * SUCH DAMAGE.
  */
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <malloc.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -38,6 +40,7 @@
 
 #include <gtest/gtest.h>
 
+#include <android-base/file.h>
 #include <android-base/test_utils.h>
 #include <bionic/malloc.h>
 #include <private/bionic_malloc_dispatch.h>
@@ -255,6 +258,24 @@ TEST_F(MallocHooksTest, DISABLED_free_hook) {
   EXPECT_TRUE(void_arg_ != nullptr) << "The free hook was called with a nullptr.";
 }
 
+TEST_F(MallocHooksTest, free_sized_hook) {
+  RunTest("*.DISABLED_free_sized_hook");
+}
+
+TEST_F(MallocHooksTest, DISABLED_free_sized_hook) {
+  Init();
+  ASSERT_TRUE(__free_hook != nullptr);
+  __free_hook = test_free_hook;
+
+  void* ptr = malloc(1024);
+  ASSERT_TRUE(ptr != nullptr);
+  free_sized(ptr, 1024);
+  write(0, ptr, 0);
+
+  EXPECT_TRUE(free_hook_called_) << "The free hook was not called for free_sized.";
+  EXPECT_TRUE(void_arg_ != nullptr) << "The free hook was called with a nullptr.";
+}
+
 TEST_F(MallocHooksTest, realloc_hook) {
   RunTest("*.DISABLED_realloc_hook");
 }
@@ -413,3 +434,58 @@ TEST_F(MallocHooksTest, DISABLED_valloc_hook) {
   EXPECT_TRUE(void_arg_ != nullptr) << "The memalign hook was called with a nullptr.";
 }
 #endif
+
+TEST_F(MallocHooksTest, heap_profile) {
+  TemporaryDir tmp_dir;
+  std::string prefix = std::string(tmp_dir.path) + "/profile";
+  ASSERT_EQ(0, setenv("LIBC_HOOKS_HEAP_PROFILE", "4096", true));
+  ASSERT_EQ(0, setenv("LIBC_HOOKS_HEAP_PROFILE_FILE", prefix.c_str(), true));
+  RunTest("*.DISABLED_heap_profile");
+  ASSERT_EQ(0, unsetenv("LIBC_HOOKS_HEAP_PROFILE"));
+  ASSERT_EQ(0, unsetenv("LIBC_HOOKS_HEAP_PROFILE_FILE"));
+
+  // Expect one profile written on the signal, and one written at exit.
+  std::vector<std::string> profiles;
+  DIR* dir = opendir(tmp_dir.path);
+  ASSERT_TRUE(dir != nullptr);
+  dirent* entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    if (entry->d_name[0] != '.') {
+      profiles.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  ASSERT_EQ(2U, profiles.size());
+
+  size_t exit_profiles = 0;
+  for (const auto& name : profiles) {
+    SCOPED_TRACE(name);
+    if (name.find(".exit.heap") != std::string::npos) {
+      exit_profiles++;
+    }
+    std::string content;
+    ASSERT_TRUE(android::base::ReadFileToString(std::string(tmp_dir.path) + "/" + name, &content));
+    ASSERT_EQ(0U, content.find("heap profile: ")) << content;
+    ASSERT_NE(std::string::npos, content.find(" @ heap_v2/4096\n")) << content;
+    ASSERT_NE(std::string::npos, content.find("\nMAPPED_LIBRARIES:\n")) << content;
+    // Some of the live allocations must have been sampled.
+    size_t live_count;
+    size_t live_bytes;
+    ASSERT_EQ(2, sscanf(content.c_str(), "heap profile: %zu: %zu", &live_count, &live_bytes));
+    EXPECT_NE(0U, live_count);
+    EXPECT_NE(0U, live_bytes);
+  }
+  EXPECT_EQ(1U, exit_profiles);
+}
+
+TEST_F(MallocHooksTest, DISABLED_heap_profile) {
+  // These are never freed, so they are live in both profiles.
+  for (size_t i = 0; i < 1000; i++) {
+    void* ptr = malloc(1024);
+    ASSERT_TRUE(ptr != nullptr);
+    write(0, ptr, 0);
+  }
+  raise(SIGRTMAX - 17);
+  // The profile is written by the next allocation after the signal.
+  free(malloc(1));
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+// The name of the environment variable that forces libc's ifunc resolvers to pick a particular
+// variant, for example "strlen=generic,memcpy=avx2". Entries naming a variant that doesn't exist
+// or can't run on this CPU are ignored. Like the other LIBC_ variables, it's removed from the
+// environment of AT_SECURE processes.
+#define ANDROID_IFUNC_OVERRIDE_ENV "LIBC_IFUNC_OVERRIDE"
+
+// One implementation of a function that libc selects between at load time.
+struct android_ifunc_variant {
+  // The name of the variant, as used in ANDROID_IFUNC_OVERRIDE_ENV (for example "avx2").
+  const char* name;
+  // The implementation. It's only safe to call if `supported` is true.
+  void* func;
+  // Whether this CPU can run the variant.
+  bool supported;
+  // Whether this is the variant the function resolved to in this process.
+  bool selected;
+};
+
+// Returns the name of the `index`th function that libc resolves with an ifunc and can describe
+// the variants of, or NULL if `index` is past the end. Static executables call their string
+// functions directly, so there are no such functions there.
+const char* android_ifunc_get_function(size_t index);
+
+// Fills in up to `count` variants of `function`, in the order the resolver prefers them, and
+// returns the total number of variants. Returns 0 if `function` isn't one of the functions
+// returned by android_ifunc_get_function().
+size_t android_ifunc_get_variants(const char* function, struct android_ifunc_variant* variants,
+                                  size_t count);
+
+__END_DECLS
@@ -103,6 +103,15 @@ enum {
   // Query whether memtag stack is enabled for this process.
   M_MEMTAG_STACK_IS_ON = 11,
 #define M_MEMTAG_STACK_IS_ON M_MEMTAG_STACK_IS_ON
+  // Take a snapshot of the native allocator's counters for each size class
+  // in each arena. The counters are kept by the allocator anyway, so this is
+  // cheap enough to poll regularly. If stats->max_stats is too small, fails
+  // with ENOBUFS after setting stats->num_stats to the number needed.
+  // Fails with ENOTSUP if the allocator doesn't keep these counters.
+  //   arg = android_mallopt_size_class_stats_t*
+  //   arg_size = sizeof(android_mallopt_size_class_stats_t)
+  M_GET_SIZE_CLASS_STATS = 12,
+#define M_GET_SIZE_CLASS_STATS M_GET_SIZE_CLASS_STATS
 };
 
 typedef struct {
@@ -148,6 +157,46 @@ typedef struct {
   Action desire = DONT_TURN_ON_UNLESS_OVERRIDDEN;
 } android_mallopt_gwp_asan_options_t;
 
+typedef struct {
+  // The largest allocation size in this size class.
+  size_t size;
+  // The allocator arena the counters are for.
+  uint32_t arena;
+  // The number of allocations from, and frees to, this size class since the
+  // arena was created. Allocators with thread caches count an object when it
+  // moves between a thread cache and the arena, so these can lag behind calls
+  // to malloc and free.
+  uint64_t num_allocs;
+  uint64_t num_frees;
+  // Bytes in allocations that have not been returned to the arena.
+  size_t live_bytes;
+  // Bytes the arena holds for this size class that are not allocated.
+  size_t cached_bytes;
+} android_malloc_size_class_stats_t;
+
+typedef struct {
+  // Array of max_stats entries, provided by the caller, that is filled in.
+  android_malloc_size_class_stats_t* stats = nullptr;
+  size_t max_stats = 0;
+  // Set to the number of size classes in the snapshot. Size classes that
+  // have never been used are left out.
+  size_t num_stats = 0;
+} android_mallopt_size_class_stats_t;
+
+// Allocates `count` objects of `size` bytes each, storing them in `ptrs`. This
+// only goes through the malloc dispatch once, and lets allocators that can
+// amortize work across a batch do so. Only for use by the Android platform and
+// APEXes.
+//
+// Returns the number of objects allocated, stored in the first entries of
+// `ptrs`. This is less than `count` only if an allocation failed.
+extern "C" size_t android_malloc_batch(size_t size, void** ptrs, size_t count);
+
+// Frees the `count` pointers in `ptrs`, which may include null pointers. The
+// contents of `ptrs` are unspecified afterwards. Only for use by the Android
+// platform and APEXes.
+extern "C" void android_free_batch(void** ptrs, size_t count);
+
 // Manipulates bionic-specific handling of memory allocation APIs such as
 // malloc. Only for use by the Android platform and APEXes.
 //
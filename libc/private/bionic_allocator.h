@@ -36,6 +36,8 @@
 #include <stddef.h>
 #include <unistd.h>
 
+#include "private/bionic_lock.h"
+
 const uint32_t kSmallObjectMaxSizeLog2 = 10;
 const uint32_t kSmallObjectMinSizeLog2 = 4;
 const uint32_t kSmallObjectAllocatorsCount = kSmallObjectMaxSizeLog2 - kSmallObjectMinSizeLog2 + 1;
@@ -101,9 +103,18 @@ class BionicSmallObjectAllocator {
   small_object_page_info* page_list_;
 };
 
+// A bounded per-thread stash of free small-object blocks, one list per size
+// class, in front of a shared BionicAllocator. The owner (e.g. a thread's
+// pthread_internal_t) must flush it before the storage goes away, and must
+// not let a signal handler on the same thread use it concurrently.
+struct BionicAllocatorCache {
+  small_object_block_record* free_lists[kSmallObjectAllocatorsCount];
+  uint8_t counts[kSmallObjectAllocatorsCount];
+};
+
 class BionicAllocator {
  public:
-  constexpr BionicAllocator() : allocators_(nullptr), allocators_buf_() {}
+  constexpr BionicAllocator() : allocators_(nullptr), allocators_buf_(), lock_() {}
   void* alloc(size_t size);
   void* memalign(size_t align, size_t size);
 
@@ -111,13 +122,27 @@ class BionicAllocator {
   void* realloc(void* ptr, size_t size);
   void free(void* ptr);
 
+  // Thread-safe variants of the above, served from the calling thread's cache
+  // when possible. The allocator is only touched, under an internal lock, to
+  // refill an empty cache list or drain a full one. An allocator must not mix
+  // these with the unsynchronized calls above.
+  void* alloc(size_t size, BionicAllocatorCache* cache);
+  void* memalign(size_t align, size_t size, BionicAllocatorCache* cache);
+  void free(void* ptr, BionicAllocatorCache* cache);
+
+  // Returns every block in the cache to the allocator.
+  void flush_cache(BionicAllocatorCache* cache);
+
   // Returns the size of the given allocated heap chunk, if it is valid.
   // Otherwise, this may return 0 or cause a segfault if the pointer is invalid.
   size_t get_chunk_size(void* ptr);
 
  private:
   void* alloc_mmap(size_t align, size_t size);
+  inline uint32_t small_object_type(size_t size);
   inline void* alloc_impl(size_t align, size_t size);
+  void* alloc_cached(size_t align, size_t size, BionicAllocatorCache* cache);
+  void drain_cache_list(BionicAllocatorCache* cache, uint32_t type, size_t keep);
   inline page_info* get_page_info_unchecked(void* ptr);
   inline page_info* get_page_info(void* ptr);
   BionicSmallObjectAllocator* get_small_object_allocator(uint32_t type);
@@ -125,4 +150,5 @@ class BionicAllocator {
 
   BionicSmallObjectAllocator* allocators_;
   uint8_t allocators_buf_[sizeof(BionicSmallObjectAllocator)*kSmallObjectAllocatorsCount];
+  Lock lock_;
 };
@@ -42,8 +42,16 @@
 #include "private/bionic_fdsan.h"
 #include "private/bionic_malloc_dispatch.h"
 #include "private/bionic_vdso.h"
+#if defined(__x86_64__)
+#include "private/bionic_x86_64_cache_info.h"
+#endif
 
 struct libc_globals {
+#if defined(__x86_64__)
+  // This must stay first: the string routines in assembler address it as
+  // __libc_globals plus a constant offset.
+  x86_64_cache_info cache_info;
+#endif
   vdso_entry vdso[VDSO_END];
   long setjmp_cookie;
   uintptr_t heap_pointer_tag;
@@ -130,6 +138,10 @@ __LIBC_HIDDEN__ void __libc_init_malloc(libc_globals* globals);
 __LIBC_HIDDEN__ void __libc_init_setjmp_cookie(libc_globals* globals);
 __LIBC_HIDDEN__ void __libc_init_vdso(libc_globals* globals);
 
+#if defined(__x86_64__)
+__LIBC_HIDDEN__ void __libc_init_x86_64_cache_info(libc_globals* globals);
+#endif
+
 #if defined(__i386__)
 __LIBC_HIDDEN__ extern void* __libc_sysinfo;
 extern "C" __LIBC_HIDDEN__ void __libc_int0x80();
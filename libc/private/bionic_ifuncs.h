@@ -28,16 +28,32 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/ifunc.h>
 
+#include "platform/bionic/ifunc.h"
+
+// Bionic passes its resolvers one more argument than the ABI requires: the value of
+// LIBC_IFUNC_OVERRIDE, or null. Resolvers that don't expect it just ignore it.
 #if defined(__aarch64__)
 #define IFUNC_ARGS (uint64_t hwcap __attribute__((unused)), \
-                    __ifunc_arg_t* arg __attribute__((unused)))
+                    __ifunc_arg_t* arg __attribute__((unused)), \
+                    const char* ifunc_overrides __attribute__((unused)))
+#define IFUNC_VARIANTS_ARGS (IfuncVariantVisitor* visitor, \
+                             uint64_t hwcap __attribute__((unused)), \
+                             __ifunc_arg_t* arg __attribute__((unused)))
+#define IFUNC_VARIANTS_CALL(visitor) (visitor, hwcap, arg)
 #elif defined(__arm__)
-#define IFUNC_ARGS (unsigned long hwcap __attribute__((unused)))
+#define IFUNC_ARGS (unsigned long hwcap __attribute__((unused)), \
+                    const char* ifunc_overrides __attribute__((unused)))
+#define IFUNC_VARIANTS_ARGS (IfuncVariantVisitor* visitor, \
+                             unsigned long hwcap __attribute__((unused)))
+#define IFUNC_VARIANTS_CALL(visitor) (visitor, hwcap)
 #else
-#define IFUNC_ARGS ()
+#define IFUNC_ARGS (const char* ifunc_overrides __attribute__((unused)))
+#define IFUNC_VARIANTS_ARGS (IfuncVariantVisitor* visitor)
+#define IFUNC_VARIANTS_CALL(visitor) (visitor)
 #endif
 
 // We can't have HWASAN enabled in resolvers because they may be called before HWASAN is
@@ -56,3 +72,104 @@
         DECLARE_FUNC(type, name); \
         return name; \
     }
+
+// Resolvers run before libc has been relocated, so nothing here can call into the rest of libc
+// (not even strcmp, which is itself an ifunc) or use data that needs a relocation.
+
+// Returns the variant LIBC_IFUNC_OVERRIDE asks for for `name`, terminated by ',' or '\0'.
+__attribute__((no_sanitize("hwaddress")))
+static inline const char* __bionic_ifunc_find_override(const char* overrides, const char* name) {
+  if (overrides == nullptr) return nullptr;
+  const char* p = overrides;
+  while (*p != '\0') {
+    const char* n = name;
+    while (*n != '\0' && *p == *n) {
+      ++p;
+      ++n;
+    }
+    if (*n == '\0' && *p == '=') return p + 1;
+    // Skip to the next entry.
+    while (*p != '\0' && *p != ',') ++p;
+    if (*p == ',') ++p;
+  }
+  return nullptr;
+}
+
+// Collects the variants listed by a DEFINE_IFUNC_VARIANTS body. A resolver uses it to select
+// one; android_ifunc_get_variants() uses it to list them all.
+struct IfuncVariantVisitor {
+  // Selects the first supported variant, or the one named by `override` if that's supported.
+  explicit IfuncVariantVisitor(const char* wanted) : override(wanted) {}
+
+  // Lists every variant, filling in up to `count` entries of `variants`.
+  IfuncVariantVisitor(android_ifunc_variant* out, size_t count)
+      : listing(true), variants(out), variant_count(count) {}
+
+  // Returns true once the visitor doesn't need to see any more variants.
+  __attribute__((no_sanitize("hwaddress")))
+  bool visit(const char* name, void* func, bool supported) {
+    if (listing) {
+      if (total < variant_count) variants[total] = {name, func, supported, false};
+      ++total;
+      return false;
+    }
+    if (!supported) return false;
+    if (result == nullptr) result = func;
+    if (override == nullptr) return true;
+
+    const char* o = override;
+    const char* n = name;
+    while (*n != '\0' && *o == *n) {
+      ++o;
+      ++n;
+    }
+    if (*n == '\0' && (*o == '\0' || *o == ',')) {
+      result = func;
+      return true;
+    }
+    return false;
+  }
+
+  const char* override = nullptr;
+  void* result = nullptr;
+
+  bool listing = false;
+  android_ifunc_variant* variants = nullptr;
+  size_t variant_count = 0;
+  size_t total = 0;
+};
+
+// Defines an ifunc whose resolver is a list of IFUNC_VARIANTs, most preferred first, so that the
+// variants can be listed and overridden. The body runs once per resolution or listing, so it
+// should do any CPU detection itself.
+#define DEFINE_IFUNC_VARIANTS(name) \
+    static void name##_variants IFUNC_VARIANTS_ARGS; \
+    DEFINE_IFUNC_FOR(name) { \
+        IfuncVariantVisitor visitor(__bionic_ifunc_find_override(ifunc_overrides, #name)); \
+        name##_variants IFUNC_VARIANTS_CALL(&visitor); \
+        return reinterpret_cast<name##_func*>(visitor.result); \
+    } \
+    __attribute__((no_sanitize("hwaddress"))) \
+    static void name##_variants IFUNC_VARIANTS_ARGS
+
+#define IFUNC_VARIANT(type, variant, name, supported) { \
+        DECLARE_FUNC(type, name); \
+        if (visitor->visit(variant, reinterpret_cast<void*>(name), supported)) return; \
+    }
+
+typedef void ifunc_variants_func IFUNC_VARIANTS_ARGS;
+
+// One entry per DEFINE_IFUNC_VARIANTS function, terminated by an entry with a null name.
+struct IfuncVariantTableEntry {
+  const char* name;
+  ifunc_variants_func* variants;
+  // What the ifunc resolved to.
+  void* resolved;
+};
+
+#define IFUNC_VARIANT_TABLE_ENTRY(name) \
+    { #name, name##_variants, reinterpret_cast<void*>(name) }
+
+// Defined by the architectures whose resolvers use DEFINE_IFUNC_VARIANTS.
+extern "C" __attribute__((visibility("hidden"))) __attribute__((weak))
+const IfuncVariantTableEntry __bionic_ifunc_variant_table[];
@@ -37,6 +37,10 @@
 // Entry in malloc dispatch table.
 typedef void* (*MallocCalloc)(size_t, size_t);
 typedef void (*MallocFree)(void*);
+typedef void (*MallocFreeSized)(void*, size_t);
+typedef void (*MallocFreeAlignedSized)(void*, size_t, size_t);
+typedef size_t (*MallocMallocBatch)(size_t, void**, size_t);
+typedef void (*MallocFreeBatch)(void**, size_t);
 typedef struct mallinfo (*MallocMallinfo)();
 typedef void* (*MallocMalloc)(size_t);
 typedef int (*MallocMallocInfo)(int, FILE*);
@@ -76,6 +80,13 @@ struct MallocDispatch {
   MallocMallopt mallopt;
   MallocAlignedAlloc aligned_alloc;
   MallocMallocInfo malloc_info;
+  // These two may be null, in which case free is called instead.
+  MallocFreeSized free_sized;
+  MallocFreeAlignedSized free_aligned_sized;
+  // These two may be null, in which case malloc and free are called once
+  // for each object.
+  MallocMallocBatch malloc_batch;
+  MallocFreeBatch free_batch;
 } __attribute__((aligned(32)));
 
 #endif
@@ -34,6 +34,8 @@
 #include <sys/cdefs.h>
 #include <sys/param.h>
 
+#include <linux/rseq.h>
+
 #include <platform/bionic/tls.h>
 
 #include "platform/bionic/macros.h"
@@ -132,6 +134,11 @@ struct bionic_tls {
   char bionic_systrace_disabled;
   char padding[2];
 
+  // The thread's restartable sequences area. It's registered once the thread's
+  // bionic_tls is in its final place in static TLS, at __rseq_offset from the
+  // thread pointer; until then cpu_id is RSEQ_CPU_ID_UNINITIALIZED.
+  struct rseq rseq_area;
+
   // Initialize the main thread's final object using its bootstrap object.
   void copy_from_bootstrap(const bionic_tls* boot __attribute__((unused))) {
     // Nothing in bionic_tls needs to be preserved in the transition to the
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#pragma once
+
+// Cache sizes used by the x86_64 string routines to pick between temporal and
+// non-temporal code paths. These are filled in from CPUID at startup by
+// __libc_init_x86_64_cache_info() and live at the start of libc_globals so the
+// assembler can address them as fixed offsets from __libc_globals.
+
+#define X86_64_CACHE_INFO_DATA_CACHE_SIZE 0
+#define X86_64_CACHE_INFO_DATA_CACHE_SIZE_HALF 8
+#define X86_64_CACHE_INFO_SHARED_CACHE_SIZE 16
+#define X86_64_CACHE_INFO_SHARED_CACHE_SIZE_HALF 24
+
+// Used when CPUID doesn't describe the caches (very old or virtualized CPUs).
+// These match the compile-time constants the string routines used to hardcode.
+#define X86_64_DEFAULT_DATA_CACHE_SIZE (24 * 1024)
+#define X86_64_DEFAULT_SHARED_CACHE_SIZE (4096 * 1024)
+
+#if !defined(__ASSEMBLER__)
+
+#include <stddef.h>
+
+struct x86_64_cache_info {
+  size_t data_cache_size;
+  size_t data_cache_size_half;
+  size_t shared_cache_size;
+  size_t shared_cache_size_half;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <pthread.h>
+#include <stdbool.h>
 
 __BEGIN_DECLS
 
@@ -24,6 +25,13 @@ __BEGIN_DECLS
 #define _MUTEX_LOCK(l) pthread_mutex_lock((pthread_mutex_t*) l)
 #define _MUTEX_UNLOCK(l) pthread_mutex_unlock((pthread_mutex_t*) l)
 
+/*
+ * Set before the process first creates a thread that shares its address
+ * space, and never cleared. Until then there's nothing to race with, so
+ * internal locking can be skipped.
+ */
+__LIBC_HIDDEN__ extern bool __libc_multithreaded;
+
 __LIBC_HIDDEN__ void    _thread_arc4_lock(void);
 __LIBC_HIDDEN__ void    _thread_arc4_unlock(void);
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include "local.h"
+#include "private/ErrnoRestorer.h"
+
+// Support for glibc's fopen(3) 'm' flag: a read-only FILE whose buffer is a
+// private mapping of the whole file, so reads need neither read(2) nor a copy
+// into a separate buffer. The mapping is a snapshot of the file's size at open
+// time: anything appended later isn't seen, and truncating the file while it's
+// open will cause SIGBUS, as with any other mapping.
+
+struct fmmap_cookie {
+  FILE* fp;
+  char* base;
+  size_t size;
+  size_t pos;
+};
+
+static int fmmap_read(void* cookie, char* buf, int n) {
+  fmmap_cookie* ck = reinterpret_cast<fmmap_cookie*>(cookie);
+  size_t available = (ck->pos < ck->size) ? ck->size - ck->pos : 0;
+  n = MIN(static_cast<size_t>(n), available);
+  memcpy(buf, ck->base + ck->pos, n);
+  ck->pos += n;
+  return n;
+}
+
+static off64_t fmmap_seek(void* cookie, off64_t offset, int whence) {
+  fmmap_cookie* ck = reinterpret_cast<fmmap_cookie*>(cookie);
+  off64_t origin;
+  if (whence == SEEK_SET) {
+    origin = 0;
+  } else if (whence == SEEK_CUR) {
+    origin = ck->pos;
+  } else if (whence == SEEK_END) {
+    origin = ck->size;
+  } else {
+    errno = EINVAL;
+    return -1;
+  }
+  off64_t new_pos;
+  if (__builtin_add_overflow(origin, offset, &new_pos)) {
+    errno = EOVERFLOW;
+    return -1;
+  }
+  if (new_pos < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  // As with lseek(2), it's fine to seek past the end; reads there just return EOF.
+  ck->pos = new_pos;
+  return new_pos;
+}
+
+static int fmmap_close(void* cookie) {
+  fmmap_cookie* ck = reinterpret_cast<fmmap_cookie*>(cookie);
+  munmap(ck->base, ck->size);
+  // Close the fd the usual way so that fdsan still checks the FILE's tag.
+  int result = __sclose(ck->fp);
+  free(ck);
+  return result;
+}
+
+// Hands out the rest of the mapping as the FILE's buffer.
+static int fmmap_refill(FILE* fp) {
+  fmmap_cookie* ck = reinterpret_cast<fmmap_cookie*>(fp->_cookie);
+  if (fp->_bf._base == reinterpret_cast<unsigned char*>(ck->base)) {
+    size_t available = (ck->pos < ck->size) ? ck->size - ck->pos : 0;
+    fp->_p = reinterpret_cast<unsigned char*>(ck->base + ck->pos);
+    fp->_r = MIN(available, static_cast<size_t>(INT_MAX));
+    ck->pos += fp->_r;
+  } else {
+    // setvbuf(3) gave us a buffer of our own, so copy into that instead.
+    fp->_p = fp->_bf._base;
+    fp->_r = fmmap_read(ck, reinterpret_cast<char*>(fp->_p), fp->_bf._size);
+  }
+  if (fp->_r == 0) {
+    fp->_flags |= __SEOF;
+    return EOF;
+  }
+  return 0;
+}
+
+bool __sfmmap(FILE* fp) {
+  // Failing here just means the FILE carries on with read(2).
+  ErrnoRestorer errno_restorer;
+
+  struct stat sb;
+  if (fstat(fp->_file, &sb) == -1 || !S_ISREG(sb.st_mode) || sb.st_size <= 0) return false;
+#if !defined(__LP64__)
+  if (static_cast<uint64_t>(sb.st_size) > SIZE_MAX) return false;
+#endif
+  size_t size = sb.st_size;
+
+  fmmap_cookie* ck = reinterpret_cast<fmmap_cookie*>(malloc(sizeof(fmmap_cookie)));
+  if (ck == nullptr) return false;
+  void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fp->_file, 0);
+  if (base == MAP_FAILED) {
+    free(ck);
+    return false;
+  }
+  ck->fp = fp;
+  ck->base = reinterpret_cast<char*>(base);
+  ck->size = size;
+  ck->pos = 0;
+
+  // The fd stays open (and in `_file`) for fileno(3).
+  fp->_cookie = ck;
+  fp->_read = fmmap_read;
+  fp->_write = nullptr;
+  fp->_seek = nullptr;
+  fp->_close = fmmap_close;
+  _EXT(fp)->_seek64 = fmmap_seek;
+  _EXT(fp)->_refill = fmmap_refill;
+
+  // Not __SMBF: the buffer isn't ours to free(3) or grow.
+  fp->_bf._base = reinterpret_cast<unsigned char*>(ck->base);
+  fp->_bf._size = MIN(size, static_cast<size_t>(INT_MAX));
+  fp->_p = fp->_bf._base;
+  fp->_r = 0;
+  return true;
+}
@@ -140,6 +140,19 @@ struct __sfileext {
 
   // The pid of the child if this FILE* is from popen(3).
   pid_t _popen_pid;
+
+  // The next released FILE on __sfp()'s free list, guarded by the stdio mutex.
+  struct __sFILE* _next_free;
+  bool _on_free_list;
+
+  // Whether __srefill may grow the buffer, and how many reads in a row have
+  // filled it.
+  bool _growable_buffer;
+  int _full_refills;
+
+  // Replaces the read(2) into the buffer in __srefill, for FILEs whose data
+  // is already in memory (see fopen(3)'s 'm' flag).
+  int (*_refill)(struct __sFILE*);
 };
 
 // Values for `__sFILE::_flags`.
@@ -203,6 +216,8 @@ __LIBC32_LEGACY_PUBLIC__ int __sclose(void*);
 __LIBC32_LEGACY_PUBLIC__ int _fwalk(int (*)(FILE*));
 
 off64_t __sseek64(void*, off64_t, int);
+bool __sfmmap(FILE*);
+void __sfp_release(FILE*);
 int __sflush_locked(FILE*);
 int __swhatbuf(FILE*, size_t*, int*);
 wint_t __fgetwc_unlock(FILE*);
@@ -38,6 +38,8 @@
 #include <stdlib.h>
 #include "local.h"
 
+static int whatbuf(FILE *, size_t *, int *, int *);
+
 /*
  * Allocate a file buffer, or switch to unbuffered I/O.
  * Per the ANSI C standard, ALL tty devices default to line buffered.
@@ -52,13 +54,14 @@ __smakebuf(FILE *fp)
 	int flags;
 	size_t size;
 	int couldbetty;
+	int regular;
 
 	if (fp->_flags & __SNBF) {
 		fp->_bf._base = fp->_p = fp->_nbuf;
 		fp->_bf._size = 1;
 		return;
 	}
-	flags = __swhatbuf(fp, &size, &couldbetty);
+	flags = whatbuf(fp, &size, &couldbetty, &regular);
 	if ((p = malloc(size)) == NULL) {
 		fp->_flags |= __SNBF;
 		fp->_bf._base = fp->_p = fp->_nbuf;
@@ -71,6 +74,8 @@ __smakebuf(FILE *fp)
 	if (couldbetty && isatty(fp->_file))
 		flags |= __SLBF;
 	fp->_flags |= flags;
+	/* we picked the size, so __srefill may grow it for streaming reads */
+	_EXT(fp)->_growable_buffer = regular;
 }
 
 /*
@@ -78,9 +83,20 @@ __smakebuf(FILE *fp)
  */
 int
 __swhatbuf(FILE *fp, size_t *bufsize, int *couldbetty)
+{
+	int regular;
+
+	/* setvbuf calls this before installing the caller's choice of buffer */
+	_EXT(fp)->_growable_buffer = 0;
+	return (whatbuf(fp, bufsize, couldbetty, &regular));
+}
+
+static int
+whatbuf(FILE *fp, size_t *bufsize, int *couldbetty, int *regular)
 {
 	struct stat st;
 
+	*regular = 0;
 	if (fp->_file < 0 || fstat(fp->_file, &st) == -1) {
 		*couldbetty = 0;
 		*bufsize = BUFSIZ;
@@ -94,12 +110,21 @@ __swhatbuf(FILE *fp, size_t *bufsize, int *couldbetty)
 		return (__SNPT);
 	}
 
+	/*
+	 * Start from the file system's preferred I/O size. Pipes, sockets
+	 * and ttys rarely have more than a little to read at once, so
+	 * don't spend more than BUFSIZ on them.
+	 */
+	*bufsize = st.st_blksize;
+	if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode) && *bufsize > BUFSIZ)
+		*bufsize = BUFSIZ;
+	*regular = S_ISREG(st.st_mode);
+
 	/*
 	 * Optimise fseek() only if it is a regular file.  (The test for
 	 * __sseek is mainly paranoia.)  It is safe to set _blksize
 	 * unconditionally; it will only be used if __SOPT is also set.
 	 */
-	*bufsize = st.st_blksize;
 	fp->_blksize = st.st_blksize;
 	return ((st.st_mode & S_IFMT) == S_IFREG && fp->_seek == __sseek ?
 	    __SOPT : __SNPT);
@@ -824,4 +824,147 @@ struct helpers {
     return convbuf;
   }
 
+  // The size of the buffer fast_dtoa() needs: the longest result is the 39
+  // digits of a 127-bit integer, plus the NUL.
+  static constexpr size_t kFastDtoaBufSize = 40;
+
+  // A fast path for __dtoa() modes 2 (`ndigits` significant digits, for %e and
+  // %g) and 3 (`ndigits` digits after the decimal point, for %f). It returns
+  // the same correctly rounded (ties to even), trailing-zero-free digits and
+  // decimal point position, but writes them to `buf` rather than allocating.
+  //
+  // This works by scaling the double's exact value m * 2^e by a power of ten
+  // and doing the division and rounding in 128-bit integer arithmetic, which
+  // covers everyday values at everyday precisions. Anything that doesn't fit
+  // (very large or small exponents, high precisions, subnormals, inf and NaN,
+  // and everything on ILP32) returns nullptr so the caller can use __dtoa().
+  static char* fast_dtoa(double d, int mode, int ndigits, int* decpt, int* sign, char** rve,
+                         char* buf) {
+#if defined(__SIZEOF_INT128__)
+    using u128 = unsigned __int128;
+    static constexpr int kMaxPow10 = 38;  // The largest power of ten below 2^127.
+    struct Pow10Table {
+      u128 v[kMaxPow10 + 1];
+      constexpr Pow10Table() : v() {
+        v[0] = 1;
+        for (int i = 1; i <= kMaxPow10; ++i) v[i] = v[i - 1] * 10;
+      }
+    };
+    static constexpr Pow10Table kPow10;
+
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    int biased_exponent = (bits >> 52) & 0x7ff;
+    uint64_t fraction = bits & ((1ULL << 52) - 1);
+    if (biased_exponent == 0x7ff || (biased_exponent == 0 && fraction != 0)) return nullptr;
+    if (mode == 2 && (ndigits < 1 || ndigits > kMaxPow10)) return nullptr;
+    if (mode == 3 && (ndigits < 0 || ndigits > kMaxPow10)) return nullptr;
+
+    if (biased_exponent == 0) {
+      // Zero is "0" with the decimal point after it, whatever the mode.
+      *sign = bits >> 63;
+      buf[0] = '0';
+      buf[1] = '\0';
+      *decpt = 1;
+      *rve = buf + 1;
+      return buf;
+    }
+
+    // d == m * 2^e, with m as small as possible so that more values fit.
+    uint64_t m = fraction | (1ULL << 52);
+    int e = biased_exponent - 1075;
+    int trailing_zeros = __builtin_ctzll(m);
+    m >>= trailing_zeros;
+    e += trailing_zeros;
+    int m_bits = 64 - __builtin_clzll(m);
+
+    // For mode 2 we need the decimal exponent k (d == x.xxx * 10^k). This
+    // estimate of floor(log10(2^(e + m_bits - 1))) is either right or one low.
+    int k = ((e + m_bits - 1) * 78913) >> 18;
+
+    u128 q, r, den;
+    for (int attempt = 0;; ++attempt) {
+      // Find q and r such that d * 10^p == q + r/den.
+      int p = (mode == 2) ? ndigits - 1 - k : ndigits;
+      if (p > kMaxPow10 || p < -kMaxPow10) return nullptr;
+      u128 num = m;
+      den = 1;
+      if (e >= 0) {
+        if (m_bits + e > 127) return nullptr;
+        num <<= e;
+      } else {
+        if (-e > 126) return nullptr;
+        den <<= -e;
+      }
+      if (p >= 0) {
+        if (num > (static_cast<u128>(1) << 127) / kPow10.v[p]) return nullptr;
+        num *= kPow10.v[p];
+      } else {
+        if (den > (static_cast<u128>(1) << 126) / kPow10.v[-p]) return nullptr;
+        den *= kPow10.v[-p];
+      }
+      if (p >= 0) {
+        // The usual case: den is a power of two, so we can just shift.
+        q = num >> (e < 0 ? -e : 0);
+        r = num & (den - 1);
+      } else {
+        q = num / den;
+        r = num % den;
+      }
+      if (mode != 2) break;
+      // Check that q has exactly ndigits digits, and fix k if it doesn't.
+      if (q >= kPow10.v[ndigits]) {
+        ++k;
+      } else if (q < kPow10.v[ndigits - 1]) {
+        --k;
+      } else {
+        break;
+      }
+      if (attempt > 0) return nullptr;
+    }
+
+    // Round to nearest, ties to even.
+    if (2 * r > den || (2 * r == den && (q & 1) != 0)) ++q;
+    if (q == 0) return nullptr;  // Mode 3 rounded everything away; let __dtoa() handle it.
+
+    // Convert q to decimal, in two 64-bit halves if necessary.
+    char* end = buf + kFastDtoaBufSize - 1;
+    char* p = end;
+    uint64_t low = static_cast<uint64_t>(q);
+    uint64_t high = 0;
+    if (q > UINT64_MAX) {
+      static constexpr uint64_t k1e19 = 10000000000000000000ULL;
+      high = static_cast<uint64_t>(q / k1e19);
+      low = static_cast<uint64_t>(q % k1e19);
+      for (int i = 0; i < 19; ++i, low /= 10) *--p = '0' + low % 10;
+      low = high;
+    }
+    do {
+      *--p = '0' + low % 10;
+    } while ((low /= 10) != 0);
+    int ndig = end - p;
+
+    if (mode == 2) {
+      // Rounding up may have carried into a new digit (9.99 -> 10.0).
+      if (ndig > ndigits) {
+        ++k;
+        --ndig;
+      }
+      *decpt = k + 1;
+    } else {
+      *decpt = ndig - ndigits;
+    }
+
+    // Move the digits to the start of buf, without the trailing zeros.
+    while (p[ndig - 1] == '0') --ndig;
+    memmove(buf, p, ndig);
+    buf[ndig] = '\0';
+    *sign = bits >> 63;
+    *rve = buf + ndig;
+    return buf;
+#else
+    return nullptr;
+#endif
+  }
+
 };
@@ -44,6 +44,42 @@ lflush(FILE *fp)
 	return (0);
 }
 
+/*
+ * A FILE that keeps filling its buffer is probably streaming through a
+ * large file, so double the buffer after every few full reads, up to a
+ * limit, to make fewer and larger system calls.
+ */
+#define	GROW_AFTER_FULL_REFILLS	4
+#define	MAX_GROWN_BUFSIZ	(128 * 1024)
+
+static void
+maybe_grow_buffer(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+	unsigned char *p;
+	int size;
+
+	if (!ext->_growable_buffer || ext->_full_refills < GROW_AFTER_FULL_REFILLS ||
+	    (fp->_flags & (__SMBF|__SLBF|__SNBF)) != __SMBF)
+		return;
+	ext->_full_refills = 0;
+	if (fp->_bf._size >= MAX_GROWN_BUFSIZ) {
+		ext->_growable_buffer = 0;
+		return;
+	}
+	size = fp->_bf._size * 2;
+	if (size > MAX_GROWN_BUFSIZ)
+		size = MAX_GROWN_BUFSIZ;
+	/* the buffer is empty, so there's nothing to copy */
+	if ((p = malloc(size)) == NULL) {
+		ext->_growable_buffer = 0;
+		return;
+	}
+	free(fp->_bf._base);
+	fp->_bf._base = p;
+	fp->_bf._size = size;
+}
+
 /*
  * Refill a stdio buffer.
  * Return EOF on eof or error, 0 otherwise.
@@ -109,8 +145,17 @@ __srefill(FILE *fp)
 		if ((fp->_flags & (__SLBF|__SWR)) == (__SLBF|__SWR))
 			__sflush(fp);
 	}
+	/* the data may already be in memory */
+	if (_EXT(fp)->_refill != NULL)
+		return ((*_EXT(fp)->_refill)(fp));
+
+	maybe_grow_buffer(fp);
 	fp->_p = fp->_bf._base;
 	fp->_r = (*fp->_read)(fp->_cookie, (char *)fp->_p, fp->_bf._size);
+	if (fp->_r > 0 && (size_t)fp->_r == (size_t)fp->_bf._size)
+		_EXT(fp)->_full_refills++;
+	else
+		_EXT(fp)->_full_refills = 0;
 	if (fp->_r <= 0) {
 		if (fp->_r == 0)
 			fp->_flags |= __SEOF;
@@ -43,6 +43,7 @@
 #include <sys/param.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -60,7 +61,8 @@
 
 #include "private/bsd_sys_param.h" // For ALIGN/ALIGNBYTES.
 
-#define	NDYNAMIC 10		/* add ten more whenever necessary */
+#define	NDYNAMIC 10		/* add at least ten more whenever necessary */
+#define	NDYNAMIC_MAX 256	/* but no more than this many at a time */
 
 #define PRINTF_IMPL(expr) \
     va_list ap; \
@@ -106,6 +108,10 @@ FILE* stderr = &__sF[2];
 
 static pthread_mutex_t __stdio_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Released FILEs, so that __sfp() doesn't have to search every glue block.
+// Guarded by __stdio_mutex.
+static FILE* __sfp_free_list = nullptr;
+
 static uint64_t __get_file_tag(FILE* fp) {
   // Don't use a tag for the standard streams.
   // They don't really own their file descriptors, because the values are well-known, and you're
@@ -121,17 +127,23 @@ static uint64_t __get_file_tag(FILE* fp) {
 struct glue __sglue = { nullptr, 3, __sF };
 static struct glue* lastglue = &__sglue;
 
+// Nothing can contend for a FILE's lock until the process creates a thread,
+// so this doesn't take it before then. Whether the lock was taken has to be
+// remembered, since a funopen() callback could create a thread before the
+// destructor runs.
 class ScopedFileLock {
  public:
-  explicit ScopedFileLock(FILE* fp) : fp_(fp) {
-    FLOCKFILE(fp_);
+  explicit ScopedFileLock(FILE* fp)
+      : fp_(fp), locked_(__libc_multithreaded && !_EXT(fp)->_caller_handles_locking) {
+    if (locked_) flockfile(fp_);
   }
   ~ScopedFileLock() {
-    FUNLOCKFILE(fp_);
+    if (locked_) funlockfile(fp_);
   }
 
  private:
   FILE* fp_;
+  bool locked_;
 };
 
 static glue* moreglue(int n) {
@@ -160,28 +172,58 @@ static inline void free_fgetln_buffer(FILE* fp) {
   }
 }
 
+static void __sfp_push_free_locked(FILE* fp) {
+  // freopen() can reuse a released FILE without taking it off the list, so
+  // it might already be there when it's released again.
+  if (_EXT(fp)->_on_free_list) return;
+  _EXT(fp)->_next_free = __sfp_free_list;
+  _EXT(fp)->_on_free_list = true;
+  __sfp_free_list = fp;
+}
+
+// Releases a FILE for reuse by __sfp(). Anything that gives up a FILE it got
+// from __sfp() must use this rather than just clearing _flags, or the FILE
+// will never be reused.
+void __sfp_release(FILE* fp) {
+  pthread_mutex_lock(&__stdio_mutex);
+  fp->_flags = 0;
+  __sfp_push_free_locked(fp);
+  pthread_mutex_unlock(&__stdio_mutex);
+}
+
 /*
  * Find a free FILE for fopen et al.
  */
 FILE* __sfp(void) {
-	FILE *fp;
-	int n;
+	FILE *fp = nullptr;
 	struct glue *g;
+	int n;
 
 	pthread_mutex_lock(&__stdio_mutex);
-	for (g = &__sglue; g != nullptr; g = g->next) {
-		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
-			if (fp->_flags == 0)
-				goto found;
+	while (__sfp_free_list != nullptr) {
+		FILE* candidate = __sfp_free_list;
+		__sfp_free_list = _EXT(candidate)->_next_free;
+		_EXT(candidate)->_on_free_list = false;
+		/* skip any that freopen() has put back into use */
+		if (candidate->_flags == 0) {
+			fp = candidate;
+			goto found;
+		}
 	}
 
+	/* double with each block, so there are few blocks to walk */
+	n = MIN(MAX(2 * lastglue->niobs, NDYNAMIC), NDYNAMIC_MAX);
+
 	/* release lock while mallocing */
 	pthread_mutex_unlock(&__stdio_mutex);
-	if ((g = moreglue(NDYNAMIC)) == nullptr) return nullptr;
+	if ((g = moreglue(n)) == nullptr) return nullptr;
 	pthread_mutex_lock(&__stdio_mutex);
 	lastglue->next = g;
 	lastglue = g;
 	fp = g->iobs;
+	/* push the rest in reverse, so they're handed out in address order */
+	while (--n > 0)
+		__sfp_push_free_locked(&g->iobs[n]);
 found:
 	fp->_flags = 1;		/* reserve this slot; caller sets real flags */
 	pthread_mutex_unlock(&__stdio_mutex);
@@ -241,6 +283,7 @@ static FILE* __FILE_init(FILE* fp, int fd, int flags) {
   fp->_write = __swrite;
   fp->_close = __sclose;
   _EXT(fp)->_seek64 = __sseek64;
+  _EXT(fp)->_refill = nullptr;
   return fp;
 }
 
@@ -264,6 +307,11 @@ FILE* fopen(const char* file, const char* mode) {
   // For append mode, O_APPEND sets the write position for free, but we need to
   // set the read position manually.
   if ((mode_flags & O_APPEND) != 0) __sseek64(fp, 0, SEEK_END);
+
+  // glibc's 'm' flag asks for reads to come from a mapping of the file.
+  // __sflags ignores it, and it only makes sense for read-only streams.
+  // Files that can't be mapped (pipes, /proc, empty files) use read(2) as usual.
+  if (flags == __SRD && strchr(mode, 'm') != nullptr) __sfmmap(fp);
   return fp;
 }
 __strong_alias(fopen64, fopen);
@@ -378,7 +426,7 @@ FILE* freopen(const char* file, const char* mode, FILE* fp) {
   fp->_lb._size = 0;
 
   if (fd < 0) { // Did not get it after all.
-    fp->_flags = 0; // Release.
+    __sfp_release(fp);
     errno = sverrno; // Restore errno in case _close clobbered it.
     return nullptr;
   }
@@ -435,7 +483,7 @@ static int __FILE_close(FILE* fp) {
   fp->_r = fp->_w = 0;
 
   // Release this FILE for reuse.
-  fp->_flags = 0;
+  __sfp_release(fp);
   return r;
 }
 
@@ -623,6 +671,8 @@ int __fseeko64(FILE* fp, off64_t offset, int whence, int off_t_bits) {
   if (HASUB(fp)) FREEUB(fp);
   fp->_p = fp->_bf._base;
   fp->_r = 0;
+  // Reads after a seek aren't sequential with the ones before it.
+  _EXT(fp)->_full_refills = 0;
   /* fp->_w = 0; */	/* unnecessary (I think...) */
   fp->_flags &= ~__SEOF;
   return 0;
@@ -1129,9 +1179,22 @@ size_t fread_unlocked(void* buf, size_t size, size_t count, FILE* fp) {
 
   // Read directly into the caller's buffer.
   while (total > 0) {
-    // The _read function pointer takes an int instead of a size_t.
-    int chunk_size = MIN(total, INT_MAX);
-    ssize_t bytes_read = (*fp->_read)(fp->_cookie, dst, chunk_size);
+    ssize_t bytes_read;
+    if (fp->_read == __sread && (fp->_flags & (__SRD | __SNBF)) == __SRD && !HASUB(fp)) {
+      // The buffer is empty, so refill it with the same system call. This
+      // saves another one if the caller goes on to make smaller reads.
+      iovec iov[2] = {{dst, total}, {fp->_bf._base, static_cast<size_t>(fp->_bf._size)}};
+      bytes_read = TEMP_FAILURE_RETRY(readv(fp->_file, iov, 2));
+      if (bytes_read > 0 && static_cast<size_t>(bytes_read) > total) {
+        fp->_p = fp->_bf._base;
+        fp->_r = bytes_read - total;
+        bytes_read = total;
+      }
+    } else {
+      // The _read function pointer takes an int instead of a size_t.
+      int chunk_size = MIN(total, INT_MAX);
+      bytes_read = (*fp->_read)(fp->_cookie, dst, chunk_size);
+    }
     if (bytes_read <= 0) {
       fp->_flags |= (bytes_read == 0) ? __SEOF : __SERR;
       break;
@@ -1150,6 +1213,38 @@ size_t fwrite(const void* buf, size_t size, size_t count, FILE* fp) {
   return fwrite_unlocked(buf, size, count, fp);
 }
 
+// Writes anything in the buffer followed by `n` bytes of `data`, without
+// copying `data` into the buffer first. Only for FILEs that write to a file
+// descriptor. Returns the number of bytes of `data` written.
+static size_t __sfwrite_direct(FILE* fp, const char* data, size_t n) {
+  // As in __sflush, empty the buffer first in case of errors.
+  size_t buffered = fp->_p - fp->_bf._base;
+  fp->_p = fp->_bf._base;
+  fp->_w = (fp->_flags & (__SLBF|__SNBF)) ? 0 : fp->_bf._size;
+
+  iovec iov[2] = {{fp->_bf._base, buffered}, {const_cast<char*>(data), n}};
+  iovec* next = (buffered != 0) ? &iov[0] : &iov[1];
+  size_t data_written = 0;
+  while (data_written < n) {
+    ssize_t written = TEMP_FAILURE_RETRY(writev(fp->_file, next, &iov[2] - next));
+    if (written <= 0) {
+      fp->_flags |= __SERR;
+      break;
+    }
+    // Skip past whatever was written, which may end part way through either.
+    size_t remaining = written;
+    while (remaining > 0) {
+      size_t chunk = MIN(remaining, next->iov_len);
+      next->iov_base = static_cast<char*>(next->iov_base) + chunk;
+      next->iov_len -= chunk;
+      remaining -= chunk;
+      if (next == &iov[1]) data_written += chunk;
+      if (next->iov_len == 0 && next != &iov[1]) ++next;
+    }
+  }
+  return data_written;
+}
+
 size_t fwrite_unlocked(const void* buf, size_t size, size_t count, FILE* fp) {
   CHECK_FP(fp);
 
@@ -1162,11 +1257,20 @@ size_t fwrite_unlocked(const void* buf, size_t size, size_t count, FILE* fp) {
 
   if (n == 0) return 0;
 
+  _SET_ORIENTATION(fp, -1);
+
+  // Writes of at least a buffer's worth skip the buffer, and go out with
+  // anything already buffered in a single writev. For unbuffered and string
+  // FILEs, and those with their own write function, __sfvwrite knows best.
+  if (fp->_write == __swrite && (fp->_flags & __SNBF) == 0 && !cantwrite(fp) &&
+      n >= static_cast<size_t>(fp->_bf._size)) {
+    size_t written = __sfwrite_direct(fp, static_cast<const char*>(buf), n);
+    return (written == n) ? count : (written / size);
+  }
+
   __siov iov = { .iov_base = const_cast<void*>(buf), .iov_len = n };
   __suio uio = { .uio_iov = &iov, .uio_iovcnt = 1, .uio_resid = n };
 
-  _SET_ORIENTATION(fp, -1);
-
   // The usual case is success (__sfvwrite returns 0); skip the divide if this happens,
   // since divides are generally slow.
   return (__sfvwrite(fp, &uio) == 0) ? count : ((n - uio.uio_resid) / size);
@@ -79,6 +79,7 @@ int FUNCTION_NAME(FILE* fp, const CHAR_TYPE* fmt0, va_list ap) {
   int ndig;                   /* actual number of digits returned by dtoa */
   CHAR_TYPE expstr[MAXEXPDIG + 2]; /* buffer for exponent string: e+ZZZ */
   char* dtoaresult = nullptr;
+  char fast_dtoa_buf[helpers::kFastDtoaBufSize]; /* digits if dtoa wasn't needed */
 
   uintmax_t _umax;             /* integer arguments %[diouxX] */
   enum { BIN, OCT, DEC, HEX } base; /* base for %[bBdiouxX] conversion */
@@ -403,12 +404,17 @@ int FUNCTION_NAME(FILE* fp, const CHAR_TYPE* fmt0, va_list ap) {
           }
         } else {
           fparg.dbl = GETARG(double);
-          dtoaresult = cp = __dtoa(fparg.dbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend);
-          if (dtoaresult == nullptr) {
-            errno = ENOMEM;
-            goto error;
+          dtoaresult = nullptr;
+          cp = helpers::fast_dtoa(fparg.dbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend,
+                                  fast_dtoa_buf);
+          if (cp == nullptr) {
+            dtoaresult = cp = __dtoa(fparg.dbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend);
+            if (dtoaresult == nullptr) {
+              errno = ENOMEM;
+              goto error;
+            }
+            if (expt == 9999) expt = INT_MAX;
           }
-          if (expt == 9999) expt = INT_MAX;
         }
       fp_common:
         if (signflag) sign = '-';
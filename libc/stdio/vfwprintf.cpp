@@ -79,6 +79,8 @@ int FUNCTION_NAME(FILE* fp, const CHAR_TYPE* fmt0, va_list ap) {
   int ndig;                      /* actual number of digits returned by dtoa */
   CHAR_TYPE expstr[MAXEXPDIG + 2]; /* buffer for exponent string: e+ZZZ */
   char* dtoaresult = nullptr;
+  char fast_dtoa_buf[helpers::kFastDtoaBufSize]; /* digits if dtoa wasn't needed */
+  char* digits;                                  /* dtoaresult or fast_dtoa_buf */
 
   uintmax_t _umax;             /* integer arguments %[diouxX] */
   enum { BIN, OCT, DEC, HEX } base; /* base for %[bBdiouxX] conversion */
@@ -378,24 +380,31 @@ int FUNCTION_NAME(FILE* fp, const CHAR_TYPE* fmt0, va_list ap) {
         if (dtoaresult) __freedtoa(dtoaresult);
         if (flags & LONGDBL) {
           fparg.ldbl = GETARG(long double);
-          dtoaresult = __ldtoa(&fparg.ldbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend);
+          dtoaresult = digits =
+              __ldtoa(&fparg.ldbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend);
           if (dtoaresult == nullptr) {
             errno = ENOMEM;
             goto error;
           }
         } else {
           fparg.dbl = GETARG(double);
-          dtoaresult = __dtoa(fparg.dbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend);
-          if (dtoaresult == nullptr) {
-            errno = ENOMEM;
-            goto error;
+          dtoaresult = nullptr;
+          digits = helpers::fast_dtoa(fparg.dbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend,
+                                      fast_dtoa_buf);
+          if (digits == nullptr) {
+            dtoaresult = digits =
+                __dtoa(fparg.dbl, expchar ? 2 : 3, prec, &expt, &signflag, &dtoaend);
+            if (dtoaresult == nullptr) {
+              errno = ENOMEM;
+              goto error;
+            }
+            if (expt == 9999) expt = INT_MAX;
           }
-          if (expt == 9999) expt = INT_MAX;
         }
         free(convbuf);
-        cp = convbuf = helpers::mbsconv(dtoaresult, -1);
+        cp = convbuf = helpers::mbsconv(digits, -1);
         if (cp == nullptr) goto error;
-        ndig = dtoaend - dtoaresult;
+        ndig = dtoaend - digits;
       fp_common:
         if (signflag) sign = '-';
         if (expt == INT_MAX) { /* inf or nan */
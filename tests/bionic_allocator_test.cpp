@@ -30,6 +30,9 @@
 #include <string.h>
 #include <sys/mman.h>
 
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "private/bionic_allocator.h"
@@ -258,3 +261,60 @@ TEST(bionic_allocator, test_memalign_large) {
   ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) % 0x1000);
   allocator.free(ptr);
 }
+
+TEST(bionic_allocator, test_cache) {
+  BionicAllocator allocator;
+  BionicAllocatorCache cache = {};
+
+  // Freed blocks are reused by the next allocation of the same size class, and
+  // come back zeroed.
+  char* ptr = reinterpret_cast<char*>(allocator.alloc(100, &cache));
+  ASSERT_TRUE(ptr != nullptr);
+  memset(ptr, 0xff, 100);
+  allocator.free(ptr, &cache);
+  char* ptr2 = reinterpret_cast<char*>(allocator.alloc(120, &cache));
+  ASSERT_EQ(ptr, ptr2);
+  for (size_t i = 0; i < 128; ++i) {
+    ASSERT_EQ(0, ptr2[i]);
+  }
+  ASSERT_EQ(128U, allocator.get_chunk_size(ptr2));
+  allocator.free(ptr2, &cache);
+
+  ptr = reinterpret_cast<char*>(allocator.memalign(0x100, 0x10, &cache));
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) % 0x100);
+  allocator.free(ptr, &cache);
+
+  // Large objects bypass the cache.
+  ptr = reinterpret_cast<char*>(allocator.alloc(0x2000, &cache));
+  ASSERT_TRUE(ptr != nullptr);
+  allocator.free(ptr, &cache);
+
+  allocator.flush_cache(&cache);
+  for (size_t i = 0; i < kSmallObjectAllocatorsCount; ++i) {
+    ASSERT_EQ(0U, cache.counts[i]);
+    ASSERT_TRUE(cache.free_lists[i] == nullptr);
+  }
+}
+
+TEST(bionic_allocator, test_cache_threads) {
+  static BionicAllocator allocator;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; ++t) {
+    threads.emplace_back([]() {
+      BionicAllocatorCache cache = {};
+      std::vector<void*> ptrs;
+      for (size_t i = 0; i < 10000; ++i) {
+        size_t size = 1 + (i * 37) % 1024;
+        ptrs.push_back(allocator.alloc(size, &cache));
+        memset(ptrs.back(), 0xff, size);
+        if (ptrs.size() == 20) {
+          for (void* ptr : ptrs) allocator.free(ptr, &cache);
+          ptrs.clear();
+        }
+      }
+      for (void* ptr : ptrs) allocator.free(ptr, &cache);
+      allocator.flush_cache(&cache);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
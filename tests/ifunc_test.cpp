@@ -19,6 +19,11 @@
 #include <sys/auxv.h>
 #if defined(__BIONIC__)
 #include <sys/ifunc.h>
+
+#include <vector>
+
+#include "platform/bionic/ifunc.h"
+#include "private/bionic_ifuncs.h"
 #endif
 
 typedef int (*fn_ptr_t)();
@@ -84,4 +89,60 @@ TEST(ifunc, hwcap) {
 #endif
 }
 
+TEST(ifunc, android_ifunc_get_variants) {
+  if (android_ifunc_get_function(0) == nullptr) {
+    GTEST_SKIP() << "libc has no ifunc variants here";
+  }
+
+  for (size_t i = 0; const char* function = android_ifunc_get_function(i); ++i) {
+    size_t count = android_ifunc_get_variants(function, nullptr, 0);
+    ASSERT_GT(count, 0U) << function;
+
+    std::vector<android_ifunc_variant> variants(count);
+    ASSERT_EQ(count, android_ifunc_get_variants(function, variants.data(), variants.size()));
+    size_t selected_count = 0;
+    for (const auto& variant : variants) {
+      ASSERT_NE(nullptr, variant.name) << function;
+      ASSERT_NE(nullptr, variant.func) << function << " " << variant.name;
+      if (variant.selected) {
+        EXPECT_TRUE(variant.supported) << function << " " << variant.name;
+        ++selected_count;
+      }
+    }
+    // Zero is possible if a sanitizer runtime interposes the function.
+    EXPECT_LE(selected_count, 1U) << function;
+  }
+
+  EXPECT_EQ(0U, android_ifunc_get_variants("not_an_ifunc", nullptr, 0));
+}
+
+TEST(ifunc, override_parsing) {
+  EXPECT_EQ(nullptr, __bionic_ifunc_find_override(nullptr, "strlen"));
+  EXPECT_EQ(nullptr, __bionic_ifunc_find_override("", "strlen"));
+  EXPECT_EQ(nullptr, __bionic_ifunc_find_override("strnlen=generic", "strlen"));
+  EXPECT_EQ(nullptr, __bionic_ifunc_find_override("strle=generic", "strlen"));
+  EXPECT_STREQ("generic", __bionic_ifunc_find_override("strlen=generic", "strlen"));
+  EXPECT_STREQ("avx2,strlen=generic",
+               __bionic_ifunc_find_override("memcpy=avx2,strlen=generic", "memcpy"));
+  EXPECT_STREQ("generic", __bionic_ifunc_find_override("memcpy=avx2,strlen=generic", "strlen"));
+
+  int a, b, c;
+  auto select = [&](const char* override) {
+    IfuncVariantVisitor visitor(override);
+    if (!visitor.visit("a", &a, false) && !visitor.visit("b", &b, true)) {
+      visitor.visit("c", &c, true);
+    }
+    return visitor.result;
+  };
+  // The first supported variant wins...
+  EXPECT_EQ(&b, select(nullptr));
+  // ...unless there's a supported override...
+  EXPECT_EQ(&c, select("c"));
+  EXPECT_EQ(&c, select("c,memcpy=a"));
+  // ...but unsupported or unknown variants are ignored.
+  EXPECT_EQ(&b, select("a"));
+  EXPECT_EQ(&b, select("d"));
+  EXPECT_EQ(&b, select("cc"));
+}
+
 #endif  // defined(__BIONIC__)
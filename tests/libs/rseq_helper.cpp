@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/rseq.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Reports whether libc registered an rseq area for the main thread, and
+// whether that got in the way of the program registering its own.
+static struct rseq g_own_area;
+
+int main() {
+  int rc = syscall(__NR_rseq, &g_own_area, sizeof(g_own_area), 0, RSEQ_SIG);
+  printf("__rseq_size=%u own_rseq_busy=%d\n", __rseq_size, (rc == -1 && errno == EBUSY) ? 1 : 0);
+  return 0;
+}
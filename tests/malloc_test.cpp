@@ -807,6 +807,73 @@ TEST(malloc, reallocarray) {
 #endif
 }
 
+TEST(malloc, free_sized) {
+#if defined(__BIONIC__)
+  free_sized(nullptr, 0);
+  for (size_t size : {0U, 1U, 24U, 100U, 4096U, 100000U, 1U << 20}) {
+    SCOPED_TRACE(testing::Message() << "size " << size);
+    void* ptr = malloc(size);
+    ASSERT_TRUE(ptr != nullptr);
+    free_sized(ptr, size);
+
+    ptr = calloc(1, size);
+    ASSERT_TRUE(ptr != nullptr);
+    free_sized(ptr, size);
+
+    ptr = malloc(8);
+    ASSERT_TRUE(ptr != nullptr);
+    ptr = realloc(ptr, size + 1);
+    ASSERT_TRUE(ptr != nullptr);
+    free_sized(ptr, size + 1);
+  }
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(malloc, free_aligned_sized) {
+#if defined(__BIONIC__)
+  free_aligned_sized(nullptr, 16, 0);
+  for (size_t alignment : {8U, 16U, 64U, 4096U}) {
+    for (size_t size : {alignment, 4 * alignment, 16 * alignment}) {
+      SCOPED_TRACE(testing::Message() << "alignment " << alignment << " size " << size);
+      void* ptr = aligned_alloc(alignment, size);
+      ASSERT_TRUE(ptr != nullptr);
+      free_aligned_sized(ptr, alignment, size);
+    }
+  }
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(malloc, android_malloc_batch) {
+#if defined(__BIONIC__)
+  EXPECT_EQ(0U, android_malloc_batch(16, nullptr, 0));
+  android_free_batch(nullptr, 0);
+
+  for (size_t size : {1U, 48U, 1024U, 100000U}) {
+    SCOPED_TRACE(testing::Message() << "size " << size);
+    void* ptrs[100];
+    ASSERT_EQ(100U, android_malloc_batch(size, ptrs, 100));
+    for (size_t i = 0; i < 100; i++) {
+      ASSERT_TRUE(ptrs[i] != nullptr);
+      ASSERT_LE(size, malloc_usable_size(ptrs[i]));
+      memset(ptrs[i], static_cast<int>(i), size);
+    }
+    std::sort(std::begin(ptrs), std::end(ptrs));
+    ASSERT_TRUE(std::adjacent_find(std::begin(ptrs), std::end(ptrs)) == std::end(ptrs));
+
+    // Null entries are allowed.
+    free(ptrs[10]);
+    ptrs[10] = nullptr;
+    android_free_batch(ptrs, 100);
+  }
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
 TEST(malloc, mallinfo) {
 #if defined(__BIONIC__) || defined(ANDROID_HOST_MUSL)
   SKIP_WITH_HWASAN << "hwasan does not implement mallinfo";
@@ -1200,6 +1267,11 @@ TEST(android_mallopt, set_allocation_limit) {
                 return realloc(p, bytes) != nullptr;
               }),
               testing::ExitedWithCode(0), "");
+  EXPECT_EXIT(CheckAllocationFunction([](size_t bytes) {
+                void* ptrs[2];
+                return android_malloc_batch(bytes / 2, ptrs, 2) == 2;
+              }),
+              testing::ExitedWithCode(0), "");
 #if !defined(__LP64__)
   EXPECT_EXIT(CheckAllocationFunction([](size_t bytes) { return pvalloc(bytes) != nullptr; }),
               testing::ExitedWithCode(0), "");
@@ -1336,6 +1408,45 @@ TEST(android_mallopt, set_allocation_limit_realloc_free) {
 #endif
 }
 
+TEST(android_mallopt, set_allocation_limit_threads) {
+#if defined(__BIONIC__)
+  size_t limit = 128 * 1024 * 1024;
+  ASSERT_TRUE(android_mallopt(M_SET_ALLOCATION_LIMIT_BYTES, &limit, sizeof(limit)));
+
+  size_t max_pointers = GetMaxAllocations();
+  ASSERT_TRUE(max_pointers != 0) << "Limit never reached.";
+
+  // Allocate on some threads and free on others, so that usage is counted and
+  // uncounted on different shards.
+  static constexpr size_t kNumThreads = 8;
+  static constexpr size_t kNumAllocations = 10000;
+  std::vector<void*> ptrs[kNumThreads];
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&ptrs, i]() {
+      for (size_t j = 0; j < kNumAllocations; j++) {
+        ptrs[i].push_back(malloc(1 + (j * 97) % 4096));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  threads.clear();
+  for (size_t i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&ptrs, i]() {
+      for (void* ptr : ptrs[(i + 1) % kNumThreads]) {
+        ASSERT_TRUE(ptr != nullptr);
+        free(ptr);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  VerifyMaxPointers(max_pointers);
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
 #if defined(__BIONIC__)
 static void* SetAllocationLimit(void* data) {
   std::atomic_bool* go = reinterpret_cast<std::atomic_bool*>(data);
@@ -1434,6 +1545,68 @@ TEST(android_mallopt, memtag_stack_is_on) {
 #endif
 }
 
+TEST(android_mallopt, get_size_class_stats) {
+#if defined(__BIONIC__)
+  SKIP_WITH_HWASAN << "hwasan does not implement size class stats";
+  android_mallopt_size_class_stats_t stats;
+  errno = 0;
+  ASSERT_FALSE(android_mallopt(M_GET_SIZE_CLASS_STATS, &stats, sizeof(stats) - 1));
+  ASSERT_EQ(EINVAL, errno);
+
+  bool allocator_scudo;
+  GetAllocatorVersion(&allocator_scudo);
+  if (allocator_scudo) {
+    errno = 0;
+    ASSERT_FALSE(android_mallopt(M_GET_SIZE_CLASS_STATS, &stats, sizeof(stats)));
+    ASSERT_EQ(ENOTSUP, errno);
+    return;
+  }
+
+  // Asking with no buffer reports the size needed.
+  errno = 0;
+  ASSERT_FALSE(android_mallopt(M_GET_SIZE_CLASS_STATS, &stats, sizeof(stats)));
+  ASSERT_EQ(ENOBUFS, errno);
+  ASSERT_NE(0U, stats.num_stats);
+
+  constexpr size_t kNumAllocs = 100;
+  constexpr size_t kAllocSize = 48;
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < kNumAllocs; i++) {
+    ptrs.push_back(malloc(kAllocSize));
+    ASSERT_TRUE(ptrs.back() != nullptr);
+  }
+
+  std::vector<android_malloc_size_class_stats_t> entries(stats.num_stats + 64);
+  stats.stats = entries.data();
+  stats.max_stats = entries.size();
+  ASSERT_TRUE(android_mallopt(M_GET_SIZE_CLASS_STATS, &stats, sizeof(stats)));
+  ASSERT_LE(stats.num_stats, entries.size());
+
+  // The allocations all come from the smallest size class that holds them.
+  size_t class_size = SIZE_MAX;
+  for (size_t i = 0; i < stats.num_stats; i++) {
+    if (entries[i].size >= kAllocSize) {
+      class_size = std::min(class_size, entries[i].size);
+    }
+  }
+  size_t live_bytes = 0;
+  for (size_t i = 0; i < stats.num_stats; i++) {
+    const auto& entry = entries[i];
+    ASSERT_GE(entry.num_allocs, entry.num_frees);
+    if (entry.size == class_size) {
+      live_bytes += entry.live_bytes;
+    }
+  }
+  ASSERT_GE(live_bytes, kNumAllocs * class_size);
+
+  for (void* ptr : ptrs) {
+    free(ptr);
+  }
+#else
+  GTEST_SKIP() << "bionic extension";
+#endif
+}
+
 void TestHeapZeroing(int num_iterations, int (*get_alloc_size)(int iteration)) {
   std::vector<void*> allocs;
   constexpr int kMaxBytesToCheckZero = 64;
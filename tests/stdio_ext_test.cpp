@@ -29,6 +29,8 @@
 #include <wchar.h>
 #include <locale.h>
 
+#include <string>
+
 #include <android-base/file.h>
 
 #include "utils.h"
@@ -53,6 +55,56 @@ TEST(stdio_ext, __fbufsize) {
   fclose(fp);
 }
 
+TEST(stdio_ext, __fbufsize_grows_for_sequential_reads) {
+#if defined(__BIONIC__)
+  std::string data;
+  for (size_t i = 0; i < 1024 * 1024; ++i) data += 'a' + (i % 26);
+  TemporaryFile tf;
+  ASSERT_TRUE(android::base::WriteStringToFd(data, tf.fd));
+
+  FILE* fp = fopen(tf.path, "r");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(data[0], fgetc(fp));
+  size_t initial_size = __fbufsize(fp);
+  for (size_t i = 1; i < data.size(); ++i) ASSERT_EQ(data[i], fgetc(fp));
+  ASSERT_EQ(EOF, fgetc(fp));
+  ASSERT_GT(__fbufsize(fp), initial_size);
+
+  // Growing the buffer must not disturb the file position.
+  ASSERT_EQ(0, fseek(fp, 12345, SEEK_SET));
+  ASSERT_EQ(data[12345], fgetc(fp));
+  ASSERT_EQ(12346, ftell(fp));
+  fclose(fp);
+
+  // A buffer size chosen by the caller is left alone.
+  fp = fopen(tf.path, "r");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, setvbuf(fp, nullptr, _IOFBF, 4096));
+  for (size_t i = 0; i < data.size(); ++i) ASSERT_EQ(data[i], fgetc(fp));
+  ASSERT_EQ(4096U, __fbufsize(fp));
+  fclose(fp);
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(stdio_ext, __fbufsize_pipe) {
+#if defined(__BIONIC__)
+  // Pipes get a small buffer, whatever their st_blksize.
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(1, write(fds[1], "x", 1));
+  FILE* fp = fdopen(fds[0], "r");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ('x', fgetc(fp));
+  ASSERT_LE(__fbufsize(fp), static_cast<size_t>(BUFSIZ));
+  fclose(fp);
+  close(fds[1]);
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
 TEST(stdio_ext, __flbf) {
   FILE* fp = fopen("/proc/version", "r");
 
@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <float.h>
 #include <limits.h>
 #include <locale.h>
 #include <math.h>
@@ -30,6 +31,7 @@
 #include <unistd.h>
 #include <wchar.h>
 
+#include <algorithm>
 #include <string>
 #include <thread>
 #include <vector>
@@ -116,6 +118,73 @@ TEST(STDIO_TEST, flockfile_18208568_regular) {
   fclose(fp);
 }
 
+TEST(STDIO_TEST, many_open_streams) {
+  // Enough streams to need several blocks of FILEs, with some released and
+  // reused in the middle.
+  constexpr size_t kStreams = 1000;
+  char buf[16] = {};
+  std::vector<FILE*> fps;
+  for (size_t i = 0; i < kStreams; ++i) {
+    fps.push_back(fmemopen(buf, sizeof(buf), "r"));
+    ASSERT_TRUE(fps.back() != nullptr);
+  }
+  for (size_t i = 0; i < kStreams; i += 2) {
+    ASSERT_EQ(0, fclose(fps[i]));
+    fps[i] = nullptr;
+  }
+  for (size_t i = 0; i < kStreams; i += 2) {
+    fps[i] = fmemopen(buf, sizeof(buf), "r");
+    ASSERT_TRUE(fps[i] != nullptr);
+  }
+  for (size_t i = 0; i < kStreams; ++i) {
+    fps.push_back(fmemopen(buf, sizeof(buf), "r"));
+    ASSERT_TRUE(fps.back() != nullptr);
+  }
+
+  std::vector<FILE*> sorted(fps);
+  std::sort(sorted.begin(), sorted.end());
+  ASSERT_TRUE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+  for (FILE* fp : fps) {
+    ASSERT_EQ('\0', fgetc(fp));
+    ASSERT_EQ(0, fclose(fp));
+  }
+}
+
+TEST(STDIO_TEST, many_open_streams_few_blocks) {
+#if defined(__BIONIC__)
+  // FILEs are allocated in blocks, and fflush(nullptr) and exit() have to walk
+  // every block, so the blocks should grow as more streams are opened. Open
+  // enough streams to use up any released FILEs, then look at how many
+  // separate runs of adjacent FILEs the last 1000 come from.
+  constexpr size_t kStreams = 5000;
+  constexpr size_t kChecked = 1000;
+  char buf[16] = {};
+  std::vector<FILE*> fps;
+  for (size_t i = 0; i < kStreams; ++i) {
+    fps.push_back(fmemopen(buf, sizeof(buf), "r"));
+    ASSERT_TRUE(fps.back() != nullptr);
+  }
+
+  // The most common distance between consecutive FILEs is sizeof(FILE).
+  std::vector<uintptr_t> gaps;
+  for (size_t i = kStreams - kChecked + 1; i < kStreams; ++i) {
+    gaps.push_back(reinterpret_cast<uintptr_t>(fps[i]) - reinterpret_cast<uintptr_t>(fps[i - 1]));
+  }
+  std::vector<uintptr_t> sorted_gaps(gaps);
+  std::sort(sorted_gaps.begin(), sorted_gaps.end());
+  uintptr_t stride = sorted_gaps[sorted_gaps.size() / 2];
+  size_t blocks = 1 + std::count_if(gaps.begin(), gaps.end(), [&](uintptr_t gap) {
+    return gap != stride;
+  });
+  // Blocks of up to 256 FILEs mean 1000 FILEs span about 5 blocks.
+  EXPECT_LE(blocks, 10U);
+
+  for (FILE* fp : fps) ASSERT_EQ(0, fclose(fp));
+#else
+  GTEST_SKIP() << "glibc doesn't allocate FILEs in blocks";
+#endif
+}
+
 TEST(STDIO_TEST, tmpfile_fileno_fprintf_rewind_fgets) {
   FILE* fp = tmpfile();
   ASSERT_TRUE(fp != nullptr);
@@ -836,6 +905,45 @@ TEST(STDIO_TEST, snprintf_e) {
   EXPECT_STREQ("1.500000e+00", buf);
 }
 
+TEST(STDIO_TEST, snprintf_efg_rounding) {
+  char buf[BUFSIZ];
+
+  // Exact ties round to even.
+  snprintf(buf, sizeof(buf), "%.0f %.0f %.0f %.0f", 0.5, 1.5, 2.5, -2.5);
+  EXPECT_STREQ("0 2 2 -2", buf);
+  snprintf(buf, sizeof(buf), "%.1f %.2f %.1e", 0.25, 0.125, 1.25);
+  EXPECT_STREQ("0.2 0.12 1.2e+00", buf);
+  // ...but values that only look like ties don't.
+  snprintf(buf, sizeof(buf), "%.1f %.1f %.2f", 0.35, 0.45, 1.005);
+  EXPECT_STREQ("0.3 0.5 1.00", buf);
+
+  // Rounding up can carry into a new digit.
+  snprintf(buf, sizeof(buf), "%.2f %.2e %g %g", 9.999, 9.999, 999999.5, 0.00009999995);
+  EXPECT_STREQ("10.00 1.00e+01 1e+06 0.0001", buf);
+
+  // Everyday values.
+  snprintf(buf, sizeof(buf), "%g %g %g %g %f", 0.1, 1234.5678, 1e-5, 123456789.0, 3.14159265);
+  EXPECT_STREQ("0.1 1234.57 1e-05 1.23457e+08 3.141593", buf);
+  snprintf(buf, sizeof(buf), "%.17g %.17g %.20f", 0.1, 1.0 / 3.0, 0.1);
+  EXPECT_STREQ("0.10000000000000001 0.33333333333333331 0.10000000000000000555", buf);
+  snprintf(buf, sizeof(buf), "%#g %#.3g %-8.3f| %+08.2f", 1.0, 2.0, 1.5, 3.14159);
+  EXPECT_STREQ("1.00000 2.00 1.500   | +0003.14", buf);
+
+  // Values that need more than 128 bits of arithmetic.
+  snprintf(buf, sizeof(buf), "%g %g %.3e %g", 1e300, 5e-324, DBL_MAX, DBL_MIN);
+  EXPECT_STREQ("1e+300 4.94066e-324 1.798e+308 2.22507e-308", buf);
+  snprintf(buf, sizeof(buf), "%.40f", 0.1);
+  EXPECT_STREQ("0.1000000000000000055511151231257827021182", buf);
+  snprintf(buf, sizeof(buf), "%f", 1e25);
+  EXPECT_STREQ("10000000000000000905969664.000000", buf);
+  snprintf(buf, sizeof(buf), "%.2f %.0f", 0.001, 0.4);
+  EXPECT_STREQ("0.00 0", buf);
+
+  wchar_t wbuf[BUFSIZ];
+  swprintf(wbuf, BUFSIZ, L"%.2f %g %e", 9.999, 1234.5678, 0.0);
+  EXPECT_EQ(std::wstring(L"10.00 1234.57 0.000000e+00"), wbuf);
+}
+
 TEST(STDIO_TEST, snprintf_negative_zero_5084292) {
   char buf[BUFSIZ];
 
@@ -2725,6 +2833,201 @@ TEST(STDIO_TEST, fread_with_locked_file) {
   fclose(fp1);
 }
 
+TEST(STDIO_TEST, thread_created_during_stdio_call) {
+#if defined(__BIONIC__)
+  // A single-threaded process doesn't lock FILEs, so check that a thread
+  // created in the middle of a call neither leaves the FILE locked nor
+  // unlocks a lock that was never taken.
+  auto write_fn = [](void* cookie, const char* buf, int n) {
+    std::thread([] {}).join();
+    reinterpret_cast<std::string*>(cookie)->append(buf, n);
+    return n;
+  };
+  std::string output;
+  FILE* fp = funopen(&output, nullptr, write_fn, nullptr, nullptr);
+  ASSERT_TRUE(fp != nullptr);
+  setvbuf(fp, nullptr, _IONBF, 0);
+  ASSERT_EQ(5, fprintf(fp, "hello"));
+
+  std::thread([fp] {
+    ASSERT_EQ(0, ftrylockfile(fp));
+    funlockfile(fp);
+  }).join();
+
+  ASSERT_EQ(0, fclose(fp));
+  ASSERT_EQ("hello", output);
+#else
+  GTEST_SKIP() << "glibc uses fopencookie instead";
+#endif
+}
+
+TEST(STDIO_TEST, fputs_from_multiple_threads) {
+  // Once there are threads, each call has to hold the FILE's lock.
+  constexpr size_t kThreads = 4;
+  constexpr size_t kLines = 1000;
+  const std::string line = "the quick brown fox jumps over the lazy dog\n";
+  TemporaryFile tf;
+  FILE* fp = fdopen(tf.fd, "w+");
+  ASSERT_TRUE(fp != nullptr);
+  tf.release();
+  setvbuf(fp, nullptr, _IOFBF, 64);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; i++) {
+    threads.emplace_back([&] {
+      for (size_t j = 0; j < kLines; j++) {
+        fputs(line.c_str(), fp);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  rewind(fp);
+  char buf[128];
+  size_t count = 0;
+  while (fgets(buf, sizeof(buf), fp) != nullptr) {
+    ASSERT_EQ(line, buf);
+    count++;
+  }
+  ASSERT_EQ(kThreads * kLines, count);
+  fclose(fp);
+}
+
+TEST(STDIO_TEST, fwrite_larger_than_buffer) {
+  // A large write bypasses the buffer, but must still come after anything
+  // already buffered, and leave the buffer usable.
+  std::string data;
+  for (size_t i = 0; i < 1000; ++i) data += 'a' + (i % 26);
+
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.path, "w");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, setvbuf(fp, nullptr, _IOFBF, 64));
+  ASSERT_NE(EOF, fputs("hello ", fp));
+  ASSERT_EQ(data.size(), fwrite(data.data(), 1, data.size(), fp));
+  ASSERT_EQ(static_cast<long>(6 + data.size()), ftell(fp));
+  ASSERT_NE(EOF, fputs(" world", fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(tf.path, &contents));
+  ASSERT_EQ("hello " + data + " world", contents);
+}
+
+TEST(STDIO_TEST, fread_larger_than_buffer) {
+  // A large read bypasses the buffer, and may refill it on the way.
+  std::string data;
+  for (size_t i = 0; i < 10000; ++i) data += 'a' + (i % 26);
+  TemporaryFile tf;
+  ASSERT_TRUE(android::base::WriteStringToFd(data, tf.fd));
+
+  FILE* fp = fopen(tf.path, "r");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, setvbuf(fp, nullptr, _IOFBF, 64));
+  ASSERT_EQ(data[0], fgetc(fp));
+
+  std::vector<char> buf(1000);
+  ASSERT_EQ(buf.size(), fread(buf.data(), 1, buf.size(), fp));
+  ASSERT_EQ(data.substr(1, buf.size()), std::string(buf.begin(), buf.end()));
+  ASSERT_EQ(1001, ftell(fp));
+  ASSERT_EQ(data[1001], fgetc(fp));
+  ASSERT_EQ(1002, ftell(fp));
+
+  ASSERT_EQ(0, fseek(fp, 5000, SEEK_SET));
+  buf.resize(data.size());
+  ASSERT_EQ(data.size() - 5000, fread(buf.data(), 1, buf.size(), fp));
+  ASSERT_EQ(data.substr(5000), std::string(buf.data(), data.size() - 5000));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(STDIO_TEST, fopen_m_flag) {
+  std::string data;
+  for (size_t i = 0; i < 1000; ++i) data += "line " + std::to_string(i) + "\n";
+  TemporaryFile tf;
+  ASSERT_TRUE(android::base::WriteStringToFd(data, tf.fd));
+
+  FILE* fp = fopen(tf.path, "rme");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_NE(-1, fileno(fp));
+  ASSERT_EQ(FD_CLOEXEC, fcntl(fileno(fp), F_GETFD) & FD_CLOEXEC);
+
+  char buf[64];
+  ASSERT_STREQ("line 0\n", fgets(buf, sizeof(buf), fp));
+  ASSERT_EQ(7, ftell(fp));
+
+  char* line = nullptr;
+  size_t line_size = 0;
+  ASSERT_EQ(7, getline(&line, &line_size, fp));
+  ASSERT_STREQ("line 1\n", line);
+  free(line);
+
+  ASSERT_EQ('l', ungetc('l', fp));
+  ASSERT_EQ('l', fgetc(fp));
+  ASSERT_EQ('X', ungetc('X', fp));
+  ASSERT_EQ('X', fgetc(fp));
+  ASSERT_EQ(14, ftell(fp));
+
+  ASSERT_EQ(0, fseek(fp, -8, SEEK_END));
+  ASSERT_EQ(static_cast<long>(data.size() - 8), ftell(fp));
+  std::vector<char> rest(100);
+  ASSERT_EQ(8U, fread(rest.data(), 1, rest.size(), fp));
+  ASSERT_EQ("ine 999\n", std::string(rest.data(), 8));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(EOF, fgetc(fp));
+
+  rewind(fp);
+  std::vector<char> all(data.size());
+  ASSERT_EQ(all.size(), fread(all.data(), 1, all.size(), fp));
+  ASSERT_EQ(data, std::string(all.begin(), all.end()));
+
+  // Writing to a read-only stream still fails.
+  ASSERT_EQ(EOF, fputc('x', fp));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(STDIO_TEST, fopen_m_flag_setvbuf) {
+  std::string data(10000, 'x');
+  TemporaryFile tf;
+  ASSERT_TRUE(android::base::WriteStringToFd(data, tf.fd));
+
+  FILE* fp = fopen(tf.path, "rm");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(0, setvbuf(fp, nullptr, _IOFBF, 64));
+  std::vector<char> buf(data.size() + 1);
+  ASSERT_EQ(data.size(), fread(buf.data(), 1, buf.size(), fp));
+  ASSERT_EQ(data, std::string(buf.data(), data.size()));
+  ASSERT_EQ(0, fclose(fp));
+}
+
+TEST(STDIO_TEST, fopen_m_flag_fallback) {
+  // An empty file can't be mapped.
+  TemporaryFile tf;
+  FILE* fp = fopen(tf.path, "rm");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(EOF, fgetc(fp));
+  ASSERT_TRUE(feof(fp));
+  ASSERT_EQ(0, fclose(fp));
+
+  // Nor can a file in /proc, which claims to be empty.
+  fp = fopen("/proc/self/status", "rm");
+  ASSERT_TRUE(fp != nullptr);
+  char buf[64];
+  ASSERT_TRUE(fgets(buf, sizeof(buf), fp) != nullptr);
+  ASSERT_TRUE(android::base::StartsWith(buf, "Name:"));
+  ASSERT_EQ(0, fclose(fp));
+
+  // 'm' is ignored when writing.
+  fp = fopen(tf.path, "r+m");
+  ASSERT_TRUE(fp != nullptr);
+  ASSERT_EQ(3, fprintf(fp, "abc"));
+  rewind(fp);
+  ASSERT_EQ('a', fgetc(fp));
+  ASSERT_EQ(0, fclose(fp));
+}
+
 TEST(STDIO_TEST, SEEK_macros) {
   ASSERT_EQ(0, SEEK_SET);
   ASSERT_EQ(1, SEEK_CUR);
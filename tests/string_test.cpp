@@ -26,6 +26,7 @@
 #include <sys/cdefs.h>
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 #include "buffer_tests.h"
@@ -1617,6 +1618,85 @@ TEST(STRING_TEST, strcasestr_smoke) {
   ASSERT_EQ(haystack + 4, strcasestr(haystack, "Da"));
 }
 
+TEST(STRING_TEST, memmem_strstr_strcasestr_long) {
+  // Long enough for the vectorized search loops, and repetitive enough
+  // that most candidates where the first and last bytes match are wrong.
+  std::vector<char> haystack(64 * 1024, 'a');
+  haystack.back() = '\0';
+  std::string needle(100, 'a');
+  needle.back() = 'b';
+
+  ASSERT_EQ(nullptr, memmem(haystack.data(), haystack.size(), needle.data(), needle.size()));
+  ASSERT_EQ(nullptr, strstr(haystack.data(), needle.c_str()));
+  ASSERT_EQ(nullptr, strcasestr(haystack.data(), needle.c_str()));
+
+  // Put the needle at every offset near the end (and so at every position
+  // relative to the vector size).
+  for (size_t end = haystack.size() - 64; end < haystack.size(); ++end) {
+    std::vector<char> h(haystack);
+    h[end - 1] = 'b';
+    const char* expected = &h[end - needle.size()];
+    ASSERT_EQ(expected, memmem(h.data(), h.size(), needle.data(), needle.size())) << end;
+    ASSERT_EQ(expected, memmem(h.data(), end, needle.data(), needle.size())) << end;
+    ASSERT_EQ(nullptr, memmem(h.data(), end - 1, needle.data(), needle.size())) << end;
+    ASSERT_EQ(expected, strstr(h.data(), needle.c_str())) << end;
+    h[end - 1] = 'B';
+    ASSERT_EQ(expected, strcasestr(h.data(), needle.c_str())) << end;
+  }
+}
+
+TEST(STRING_TEST, strspn_smoke) {
+  const char* s = "aabbcc  dd";
+  ASSERT_EQ(0U, strspn(s, ""));
+  ASSERT_EQ(2U, strspn(s, "a"));
+  ASSERT_EQ(4U, strspn(s, "ab"));
+  ASSERT_EQ(6U, strspn(s, "cba"));
+  ASSERT_EQ(10U, strspn(s, "abcd "));
+  ASSERT_EQ(0U, strspn(s, "xyz"));
+  ASSERT_EQ(0U, strspn("", "abc"));
+}
+
+TEST(STRING_TEST, strcspn_smoke) {
+  const char* s = "aabbcc  dd";
+  ASSERT_EQ(10U, strcspn(s, ""));
+  ASSERT_EQ(6U, strcspn(s, " "));
+  ASSERT_EQ(2U, strcspn(s, "b"));
+  ASSERT_EQ(4U, strcspn(s, "dc"));
+  ASSERT_EQ(10U, strcspn(s, "xyz"));
+  ASSERT_EQ(0U, strcspn("", "abc"));
+}
+
+TEST(STRING_TEST, strpbrk_smoke) {
+  const char* s = "aabbcc  dd";
+  ASSERT_EQ(nullptr, strpbrk(s, ""));
+  ASSERT_EQ(s + 6, strpbrk(s, " "));
+  ASSERT_EQ(s + 2, strpbrk(s, "b"));
+  ASSERT_EQ(s + 4, strpbrk(s, "dc"));
+  ASSERT_EQ(nullptr, strpbrk(s, "xyz"));
+  ASSERT_EQ(nullptr, strpbrk("", "abc"));
+}
+
+TEST(STRING_TEST, strspn_strcspn_strpbrk_all_bytes) {
+  // Check every byte value at every position in a string long enough for
+  // the vectorized loops, including bytes with the top bit set.
+  std::string all;
+  for (int c = 1; c < 256; ++c) all += static_cast<char>(c);
+
+  for (int c = 1; c < 256; ++c) {
+    std::string accept(all);
+    accept.erase(c - 1, 1);
+    char reject[] = {static_cast<char>(c), '\xff', '\0'};
+    for (size_t pos = 0; pos < 80; ++pos) {
+      std::string s(pos, (c == 'a') ? 'b' : 'a');
+      s += static_cast<char>(c);
+      s += "tail";
+      ASSERT_EQ(pos, strspn(s.c_str(), accept.c_str())) << c << " " << pos;
+      ASSERT_EQ(pos, strcspn(s.c_str(), reject)) << c << " " << pos;
+      ASSERT_EQ(s.c_str() + pos, strpbrk(s.c_str(), reject)) << c << " " << pos;
+    }
+  }
+}
+
 TEST(STRING_TEST, strcoll_smoke) {
   ASSERT_TRUE(strcoll("aab", "aac") < 0);
   ASSERT_TRUE(strcoll("aab", "aab") == 0);
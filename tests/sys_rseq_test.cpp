@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2023 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "gtest_globals.h"
+#include "utils.h"
+
+#if defined(__BIONIC__)
+#include <sys/rseq.h>
+
+#include "platform/bionic/tls.h"
+
+static struct rseq* current_rseq_area() {
+  return reinterpret_cast<struct rseq*>(reinterpret_cast<char*>(__get_tls()) + __rseq_offset);
+}
+
+static void CheckCurrentThread() {
+  if (__rseq_size == 0) {
+    // Registration failed (old kernel or seccomp), so sched_getcpu() must
+    // still work the slow way.
+    ASSERT_LT(static_cast<int32_t>(current_rseq_area()->cpu_id), 0);
+  } else {
+    int32_t cpu = static_cast<int32_t>(current_rseq_area()->cpu_id);
+    ASSERT_GE(cpu, 0);
+    ASSERT_LT(cpu, sysconf(_SC_NPROCESSORS_CONF));
+  }
+  int cpu = sched_getcpu();
+  ASSERT_GE(cpu, 0);
+  ASSERT_LT(cpu, sysconf(_SC_NPROCESSORS_CONF));
+}
+#endif
+
+TEST(sys_rseq, main_thread) {
+#if defined(__BIONIC__)
+  ASSERT_EQ(0U, __rseq_flags);
+  CheckCurrentThread();
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(sys_rseq, new_thread) {
+#if defined(__BIONIC__)
+  std::thread t(CheckCurrentThread);
+  t.join();
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+TEST(sys_rseq, LIBC_RSEQ_0) {
+#if defined(__BIONIC__)
+  std::string helper = GetTestLibRoot() + "rseq_helper/rseq_helper";
+  chmod(helper.c_str(), 0755);  // TODO: "x" lost in CTS, b/34945607
+
+  // With registration turned off, libc must say so, and must leave the main
+  // thread free for the program to register its own area.
+  ExecTestHelper eth;
+  eth.SetArgs({helper.c_str(), nullptr});
+  eth.SetEnv({"LIBC_RSEQ=0", nullptr});
+  eth.Run([&]() { execve(helper.c_str(), eth.GetArgs(), eth.GetEnv()); }, 0,
+          "__rseq_size=0 own_rseq_busy=0\n");
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
+
+#if defined(__BIONIC__)
+struct CloneVmResult {
+  int sched_getcpu_cpu;
+  unsigned getcpu_cpu;
+};
+
+static int CloneVmChild(void* arg) {
+  CloneVmResult* result = reinterpret_cast<CloneVmResult*>(arg);
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(1, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) == -1) return 1;
+  result->sched_getcpu_cpu = sched_getcpu();
+  if (syscall(__NR_getcpu, &result->getcpu_cpu, nullptr, nullptr) == -1) return 1;
+  return 0;
+}
+#endif
+
+TEST(sys_rseq, clone_vm_without_settls) {
+#if defined(__BIONIC__)
+  if (__rseq_size == 0) GTEST_SKIP() << "no rseq area registered";
+  if (sysconf(_SC_NPROCESSORS_ONLN) < 2) GTEST_SKIP() << "needs two CPUs";
+
+  cpu_set_t original_set;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original_set), &original_set));
+  if (!CPU_ISSET(0, &original_set) || !CPU_ISSET(1, &original_set)) {
+    GTEST_SKIP() << "needs to run on CPUs 0 and 1";
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(0, &set);
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(set), &set));
+
+  // A child that shares our address space but isn't given its own TLS sees our
+  // rseq area, which the kernel doesn't update for it. This is documented in
+  // <sched.h>: sched_getcpu() reports where we (stopped by CLONE_VFORK, on
+  // CPU 0) last ran, so such children must make the system call themselves.
+  CloneVmResult result = {};
+  std::vector<char> child_stack(64 * 1024);
+  pid_t pid = clone(CloneVmChild, child_stack.data() + child_stack.size(),
+                    CLONE_VM | CLONE_VFORK | SIGCHLD, &result);
+  ASSERT_NE(-1, pid);
+  AssertChildExited(pid, 0);
+  ASSERT_EQ(0, sched_setaffinity(0, sizeof(original_set), &original_set));
+
+  ASSERT_EQ(1U, result.getcpu_cpu);
+  ASSERT_EQ(0, result.sched_getcpu_cpu);
+#else
+  GTEST_SKIP() << "bionic-only test";
+#endif
+}
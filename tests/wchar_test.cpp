@@ -1202,6 +1202,45 @@ TEST(wchar, wmemcmp) {
   ASSERT_TRUE(wmemcmp(L"aaab", L"aaaa", 4) > 0);
 }
 
+TEST(wchar, wide_string_functions_long_strings) {
+  // Exercise the vectorized implementations: every start offset within a
+  // 64-byte block, and lengths around the vector sizes.
+  wchar_t buf1[256 + 16];
+  wchar_t buf2[256 + 16];
+  for (size_t offset = 0; offset < 16; ++offset) {
+    for (size_t len = 0; len < 256; len += (len < 40) ? 1 : 23) {
+      wchar_t* s1 = buf1 + offset;
+      wchar_t* s2 = buf2 + (15 - offset);
+      wmemset(s1, L'x', len);
+      s1[len] = L'\0';
+      wmemcpy(s2, s1, len + 1);
+
+      ASSERT_EQ(len, wcslen(s1));
+      ASSERT_EQ(len, wcsnlen(s1, SIZE_MAX));
+      ASSERT_EQ(nullptr, wcschr(s1, L'y'));
+      ASSERT_EQ(s1 + len, wcschr(s1, L'\0'));
+      ASSERT_EQ(nullptr, wcsrchr(s1, L'y'));
+      ASSERT_EQ(nullptr, wmemchr(s1, L'y', len));
+      ASSERT_EQ(0, wcscmp(s1, s2));
+      ASSERT_EQ(0, wcsncmp(s1, s2, SIZE_MAX));
+      ASSERT_EQ(0, wmemcmp(s1, s2, len));
+      if (len == 0) continue;
+
+      s1[len - 1] = L'y';
+      ASSERT_EQ(s1 + len - 1, wcschr(s1, L'y'));
+      ASSERT_EQ(s1 + len - 1, wcsrchr(s1, L'y'));
+      ASSERT_EQ(s1 + len - 1, wmemchr(s1, L'y', len));
+      ASSERT_EQ(nullptr, wmemchr(s1, L'y', len - 1));
+      ASSERT_GT(wcscmp(s1, s2), 0);
+      ASSERT_LT(wcscmp(s2, s1), 0);
+      ASSERT_GT(wcsncmp(s1, s2, len), 0);
+      ASSERT_EQ(0, wcsncmp(s1, s2, len - 1));
+      ASSERT_GT(wmemcmp(s1, s2, len), 0);
+      ASSERT_EQ(0, wmemcmp(s1, s2, len - 1));
+    }
+  }
+}
+
 TEST(wchar, wmemcpy) {
   wchar_t dst[32] = {};
   ASSERT_EQ(dst, wmemcpy(dst, L"hello", 5));